@@ -6,6 +6,8 @@
 #include <string>
 #include <sstream>
 #include <concepts>
+#include <limits>
+#include <stdexcept>
 
 // dead simple ecs
 namespace dsecs3s {
@@ -24,9 +26,93 @@ namespace dsecs3s {
     template<SparseKey TKey, typename TData>
     struct SparseSet {
         using TDenseIndex = uint32_t;
+        static constexpr TDenseIndex NoIndex = std::numeric_limits<TDenseIndex>::max();
+
+        std::vector<TKey> dense; // the packed keys
+        std::vector<TData> data; // the packed values, parallel to dense
+        std::vector<TDenseIndex> sparse; // key -> index into dense, NoIndex when absent
+
+        // iteration yields `(key, value&)` pairs by value, bind them with `auto&& [k, v]`
+        template<typename TSet, typename TRef>
+        struct Iterator {
+            using difference_type = std::ptrdiff_t;
+            using value_type = std::pair<TKey, TRef>;
+
+            TSet* set = nullptr;
+            size_t i = 0;
+
+            auto operator*() const -> value_type { return { set->dense[i], set->data[i] }; }
+            auto operator++() -> Iterator& { ++i; return *this; }
+            auto operator++(int) -> Iterator { auto res = *this; ++i; return res; }
+            auto operator==(Iterator const& o) const -> bool { return i == o.i; }
+        };
+
+        auto begin() { return Iterator<SparseSet, TData&>{ this, 0 }; }
+        auto end() { return Iterator<SparseSet, TData&>{ this, dense.size() }; }
+        auto begin() const { return Iterator<SparseSet const, TData const&>{ this, 0 }; }
+        auto end() const { return Iterator<SparseSet const, TData const&>{ this, dense.size() }; }
+
+        auto size() const -> size_t { return dense.size(); }
+        auto empty() const -> bool { return dense.empty(); }
+        void clear() { dense.clear(); data.clear(); sparse.clear(); }
+
+        auto index(TKey k) const -> TDenseIndex { return (size_t(k) < sparse.size()) ? sparse[size_t(k)] : NoIndex; }
+        auto contains(TKey k) const -> bool { return index(k) != NoIndex; }
+
+        auto find(TKey k) -> TData* {
+            auto i = index(k);
+            return (i != NoIndex) ? &data[i] : nullptr;
+        }
+        auto find(TKey k) const -> TData const* {
+            auto i = index(k);
+            return (i != NoIndex) ? &data[i] : nullptr;
+        }
+
+        auto at(TKey k) -> TData& {
+            if (auto v = find(k)) return *v;
+            throw std::out_of_range("SparseSet::at");
+        }
+        auto at(TKey k) const -> TData const& {
+            if (auto v = find(k)) return *v;
+            throw std::out_of_range("SparseSet::at");
+        }
+
+        template<typename... TArgs>
+        auto emplace(TKey k, TArgs&&... args) -> TData& {
+            if (size_t(k) >= sparse.size())
+                sparse.resize(size_t(k) + 1, NoIndex);
+            sparse[size_t(k)] = TDenseIndex(dense.size());
+            dense.push_back(k);
+            return data.emplace_back(std::forward<TArgs>(args)...);
+        }
+
+        auto insert_or_assign(TKey k, TData v) -> TData& {
+            if (auto it = find(k))
+                return *it = std::move(v);
+            return emplace(k, std::move(v));
+        }
 
-        std::vector<TKey> dense;
-        std::vector<std::tuple<TDenseIndex, TData>> sparse;
+        auto operator[](TKey k) -> TData& {
+            if (auto it = find(k))
+                return *it;
+            return emplace(k);
+        }
+
+        // swap-and-pop, the last element takes the place of the erased one
+        auto erase(TKey k) -> size_t {
+            auto i = index(k);
+            if (i == NoIndex)
+                return 0;
+            if (size_t(i) + 1 != dense.size()) {
+                dense[i] = dense.back();
+                data[i] = std::move(data.back());
+                sparse[size_t(dense[i])] = i;
+            }
+            dense.pop_back();
+            data.pop_back();
+            sparse[size_t(k)] = NoIndex;
+            return 1;
+        }
     };
 
     /* entity trinity */
@@ -44,36 +130,42 @@ namespace dsecs3s {
         virtual ~ComponentManagerBase() = default;
 
         virtual auto has(Entity e) const -> bool = 0;
-        virtual auto str(Entity e) const -> std::string = 0;
         virtual void del(Entity e) = 0;
+
+        virtual auto str(Entity e) const -> std::string = 0;
     };
 
     template<typename TComp>
-    struct ComponentManager : ComponentManagerBase {
-        std::unordered_map<Entity, TComp> values; // the actual array
+    struct ComponentManager final : ComponentManagerBase {
+        SparseSet<Entity, TComp> values; // the actual array
 
         ComponentManager(std::string_view name)
             : ComponentManagerBase(name), values() { }
         virtual ~ComponentManager() = default;
 
+        virtual auto has(Entity e) const -> bool override final { return values.contains(e); }
+        virtual void del(Entity e) override final { values.erase(e); }
+
+        auto get(Entity e) const -> TComp const& { return values.at(e); }
+        auto mut(Entity e) -> TComp& { return values.at(e); }
+        void set(Entity e, TComp&& v) { values.insert_or_assign(e, std::move(v)); }
+
         void with(Entity e, std::invocable<TComp&> auto chain) {
-            if (auto it = values.find(e); it != values.end())
-                chain(it->second); // reuse the found iterator/lookup
+            if (auto v = values.find(e))
+                chain(*v); // reuse the found lookup
         }
 
-        virtual auto has(Entity e) const -> bool override { return values.contains(e); }
         virtual auto str(Entity e) const -> std::string override {
-            if (auto it = values.find(e); it != values.end())
+            if (auto v = values.find(e))
                 if constexpr (Streamable<TComp>) {
                     std::stringstream ss;
-                    ss << it->second;
+                    ss << *v;
                     return ss.str();
                 } else
                     return "<UNSTREAMABLE>";
             else
                 return "<NULL>";
         }
-        virtual void del(Entity e) override { values.erase(e); }
     };
 
     /* system trinity */
@@ -116,7 +208,7 @@ namespace dsecs3s {
             Entity _nextEntity = 1;
             std::unordered_map<size_t, std::shared_ptr<ComponentManagerBase>> _components; // the dynamic structure
             std::vector<std::shared_ptr<SystemBase>> _systems; // the dynamic update list
-            std::unordered_map<std::string_view, Entity> _entityNames;
+            std::unordered_map<std::string, Entity> _entityNames; // owns its keys, the packed Name storage moves when it grows
 
         public:
             /* trinity */
@@ -152,19 +244,18 @@ namespace dsecs3s {
             /* ergonomics I */
 
             auto findEntity(std::string_view name) -> Entity {
-                auto it = _entityNames.find(name);
+                auto it = _entityNames.find(std::string(name));
                 return (it != _entityNames.end()) ? it->second : NoEntity;
             }
 
             auto requireEntity(std::string_view name) -> Entity {
                 // early exit if the name already exists
-                // we don't attempt to reuse this lookup in this case because the string view in the index must come from the component for a safe lifetime.
                 if (auto e = findEntity(name); e != NoEntity)
                     return e;
                 
                 auto e = newEntity();
-                std::string_view name_str = (requireComponent<Name>()->values[e] = { std::string(name) }).name;
-                return _entityNames[name_str] = e;
+                requireComponent<Name>()->set(e, { std::string(name) });
+                return _entityNames[std::string(name)] = e;
             }
 
             auto allComponents() { return _components | std::views::values; }
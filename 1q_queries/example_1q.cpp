@@ -1,7 +1,7 @@
 
 #include <iostream>
 #include "compat/format"
-#include "dsecs_1s.hpp"
+#include "dsecs_1q.hpp"
 
 struct Position {
     float x, y;
@@ -55,7 +55,7 @@ int main()
     auto health = world.requireComponent<HealthStatus>();
 
     world.makeSystem("acceleration", [=](World* w) {
-        for (auto& [e, a] : acl->values) {
+        for (auto&& [e, a] : acl->values) {
             vel->with(e, [=](auto& v) {
                 v.x += a.x;
                 v.y += a.y;
@@ -64,7 +64,7 @@ int main()
     });
 
     world.makeSystem("velocity", [=](World* w) {
-        for (auto& [e, v] : vel->values) {
+        for (auto&& [e, v] : vel->values) {
             pos->with(e, [=](auto& p) {
                 p.x += v.x;
                 p.y += v.y;
@@ -73,7 +73,7 @@ int main()
     });
 
     world.makeSystem("health-tick", [=](World* w) {
-        for (auto& [e, h] : health->values) {
+        for (auto&& [e, h] : health->values) {
             double health_point_pct = 1.0 / h.maximum;  // to prevent dividing multiple times
             h.current_pct += h.delta * health_point_pct;
             if (h.current_pct <= 0.5 * health_point_pct) // less than 0.5 health points, this is effectively our epsilon.
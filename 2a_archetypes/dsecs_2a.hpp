@@ -0,0 +1,403 @@
+#pragma once
+#include <memory>
+#include <unordered_map>
+#include <map>
+#include <algorithm>
+#include <ranges>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <concepts>
+#include <stdexcept>
+
+// dead simple ecs
+namespace dsecs2a {
+    /* concepts forward declare */
+    template <typename T>
+    concept Streamable = requires(std::ostream &os, T value) {
+        { os << value } -> std::convertible_to<std::ostream &>;
+    };
+
+    /* entity trinity */
+
+    using Entity = uint64_t;
+    constexpr Entity NoEntity = 0;
+
+    /* archetype storage */
+
+    using ComponentId = size_t;
+    using Signature = std::vector<ComponentId>; // always kept sorted
+
+    template<typename TComp>
+    auto componentId() -> ComponentId { return typeid(TComp).hash_code(); }
+
+    // a type erased column, one per component type per archetype
+    struct ColumnBase {
+        virtual ~ColumnBase() = default;
+
+        virtual auto cloneEmpty() const -> std::unique_ptr<ColumnBase> = 0;
+        virtual void movePush(ColumnBase& from, size_t row) = 0; // append `from[row]` to the end of this column
+        virtual void swapPop(size_t row) = 0;
+
+        virtual auto str(size_t row) const -> std::string = 0;
+    };
+
+    template<typename TComp>
+    struct Column final : ColumnBase {
+        std::vector<TComp> values; // the actual array
+
+        virtual auto cloneEmpty() const -> std::unique_ptr<ColumnBase> override { return std::make_unique<Column>(); }
+        virtual void movePush(ColumnBase& from, size_t row) override {
+            // this static cast is safe because columns are only paired by component id
+            values.push_back(std::move(static_cast<Column&>(from).values[row]));
+        }
+        virtual void swapPop(size_t row) override {
+            if (row + 1 != values.size())
+                values[row] = std::move(values.back());
+            values.pop_back();
+        }
+
+        virtual auto str(size_t row) const -> std::string override {
+            if constexpr (Streamable<TComp>) {
+                std::stringstream ss;
+                ss << values[row];
+                return ss.str();
+            } else
+                return "<UNSTREAMABLE>";
+        }
+    };
+
+    // every entity with exactly the same set of components lives in the same archetype, one row each
+    struct Archetype {
+        Signature signature;
+        std::vector<Entity> entities; // row -> entity
+        std::vector<std::unique_ptr<ColumnBase>> columns; // parallel to signature
+
+        // cached graph edges to the archetype with one more (or one less) component
+        std::unordered_map<ComponentId, Archetype*> addEdges, delEdges;
+
+        auto size() const -> size_t { return entities.size(); }
+
+        auto column(ComponentId id) const -> ptrdiff_t {
+            auto it = std::ranges::lower_bound(signature, id);
+            return (it != signature.end() && *it == id) ? it - signature.begin() : -1;
+        }
+        auto includes(Signature const& query) const -> bool {
+            return std::ranges::includes(signature, query);
+        }
+
+        template<typename TComp>
+        auto values(size_t column) -> std::vector<TComp>& {
+            // this static cast is safe because the signature records the column's component id
+            return static_cast<Column<TComp>&>(*columns[column]).values;
+        }
+    };
+
+    /* component trinity */
+
+    struct ComponentManagerBase {
+        std::string name;
+
+        ComponentManagerBase(std::string_view name)
+            : name(name) { }
+        virtual ~ComponentManagerBase() = default;
+
+        virtual auto has(Entity e) const -> bool = 0;
+        virtual void del(Entity e) = 0;
+
+        virtual auto str(Entity e) const -> std::string = 0;
+    };
+
+    // a view of a single component type across every archetype, the archetypes own the values
+    template<typename TComp>
+    struct ComponentManager final : ComponentManagerBase {
+        class World* world;
+
+        ComponentManager(std::string_view name, class World* world)
+            : ComponentManagerBase(name), world(world) { }
+        virtual ~ComponentManager() = default;
+
+        virtual auto has(Entity e) const -> bool override final;
+        virtual void del(Entity e) override final;
+
+        auto get(Entity e) const -> TComp const&;
+        auto mut(Entity e) -> TComp&;
+        void set(Entity e, TComp&& v);
+
+        void with(Entity e, std::invocable<TComp&> auto chain);
+
+        virtual auto str(Entity e) const -> std::string override;
+    };
+
+    /* system trinity */
+
+    struct SystemBase {
+        std::string name;
+        bool enable = true;
+
+        SystemBase(std::string_view name)
+            : name(name) { }
+        virtual ~SystemBase() = default;
+
+        virtual void update(class World* w) = 0;
+    };
+
+    template<std::invocable<class World*> FExec>
+    struct SystemAnonymous : SystemBase {
+        FExec execution;
+
+        SystemAnonymous(std::string_view name, FExec execution)
+            : SystemBase(name), execution(execution) { }
+        virtual ~SystemAnonymous() = default;
+
+        virtual void update(class World* w) override { execution(w); } // the actual dispatch
+    };
+
+    /* name ergonomics */
+
+    struct Name {
+        std::string name;
+    };
+
+    auto& operator<<(std::ostream& os, Name n) {
+        return os << n.name;
+    }
+
+    /* final world type */
+
+    class World {
+            struct Record {
+                Archetype* archetype = nullptr;
+                size_t row = 0;
+            };
+
+            Entity _nextEntity = 1;
+            std::vector<Record> _records; // entity -> location, NoEntity is never used
+            std::map<Signature, std::unique_ptr<Archetype>> _archetypes; // the dynamic structure
+            Archetype* _root; // the empty signature, where new entities start
+            std::unordered_map<size_t, std::shared_ptr<ComponentManagerBase>> _components;
+            std::vector<std::shared_ptr<SystemBase>> _systems; // the dynamic update list
+            std::unordered_map<std::string, Entity> _entityNames;
+
+            auto record(Entity e) const -> Record const* {
+                return (e < _records.size() && _records[e].archetype) ? &_records[e] : nullptr;
+            }
+
+            // moves the entity's row into `to`, carrying over every column both archetypes share
+            // returns the new row, any column only `to` has is left for the caller to push
+            auto moveRow(Entity e, Archetype& to) -> size_t {
+                auto [from, row] = _records[e];
+                for (size_t i = 0; i < from->signature.size(); ++i)
+                    if (auto c = to.column(from->signature[i]); c >= 0)
+                        to.columns[c]->movePush(*from->columns[i], row);
+                removeRow(*from, row);
+                to.entities.push_back(e);
+                _records[e] = { &to, to.size() - 1 };
+                return to.size() - 1;
+            }
+
+            void removeRow(Archetype& from, size_t row) {
+                for (auto& c : from.columns)
+                    c->swapPop(row);
+                if (row + 1 != from.entities.size()) {
+                    from.entities[row] = from.entities.back();
+                    _records[from.entities[row]].row = row;
+                }
+                from.entities.pop_back();
+            }
+
+            auto requireArchetype(Signature sig, Archetype const& like, std::unique_ptr<ColumnBase> extra, ComponentId extraId) -> Archetype* {
+                if (auto it = _archetypes.find(sig); it != _archetypes.end())
+                    return it->second.get();
+                auto res = std::make_unique<Archetype>();
+                res->signature = sig;
+                for (auto id : sig) {
+                    if (id == extraId)
+                        res->columns.push_back(std::move(extra));
+                    else
+                        res->columns.push_back(like.columns[like.column(id)]->cloneEmpty());
+                }
+                return (_archetypes[sig] = std::move(res)).get();
+            }
+
+        public:
+            World() {
+                auto root = std::make_unique<Archetype>();
+                _root = root.get();
+                _archetypes[Signature{}] = std::move(root);
+            }
+
+            /* trinity */
+
+            auto newEntity() -> Entity {
+                auto e = _nextEntity++;
+                _records.resize(e + 1);
+                _root->entities.push_back(e);
+                _records[e] = { _root, _root->size() - 1 };
+                return e;
+            }
+
+            template<typename TComp>
+            auto requireComponent() -> std::shared_ptr<ComponentManager<TComp>> {
+                auto key = componentId<TComp>();
+                if (auto it = _components.find(key); it != _components.end())
+                    // this static cast is safe because we index by typeid
+                    return std::static_pointer_cast<ComponentManager<TComp>>(it->second);
+                auto res = std::make_shared<ComponentManager<TComp>>(typeid(TComp).name(), this);
+                _components[key] = res;
+                return res;
+            }
+
+            auto allEntities() { return std::ranges::iota_view(1u, _nextEntity); }
+
+            auto allArchetypes() { return _archetypes | std::views::values; }
+
+            void update() {
+                for (auto sys : _systems | std::views::filter(&SystemBase::enable)) {
+                    sys->update(this);
+                }
+            }
+
+            template<std::invocable<World*> FExec>
+            auto makeSystem(std::string_view name, FExec exec) -> std::shared_ptr<SystemAnonymous<FExec>> {
+                auto res = std::make_shared<SystemAnonymous<FExec>>(name, exec);
+                _systems.emplace_back(res);
+                return res;
+            }
+
+            /* archetype access */
+
+            template<typename TComp>
+            auto find(Entity e) -> TComp* {
+                auto r = record(e);
+                if (!r) return nullptr;
+                auto c = r->archetype->column(componentId<TComp>());
+                return (c >= 0) ? &r->archetype->values<TComp>(c)[r->row] : nullptr;
+            }
+
+            auto has(Entity e, ComponentId id) const -> bool {
+                auto r = record(e);
+                return r && r->archetype->column(id) >= 0;
+            }
+
+            auto str(Entity e, ComponentId id) const -> std::string {
+                auto r = record(e);
+                if (!r) return "<NULL>";
+                auto c = r->archetype->column(id);
+                return (c >= 0) ? r->archetype->columns[c]->str(r->row) : "<NULL>";
+            }
+
+            template<typename TComp>
+            auto set(Entity e, TComp v) -> TComp& {
+                if (auto it = find<TComp>(e))
+                    return *it = std::move(v);
+                if (!record(e))
+                    throw std::out_of_range("World::set on a dead entity");
+
+                auto id = componentId<TComp>();
+                auto& from = *_records[e].archetype;
+                auto& to = from.addEdges[id];
+                if (!to) {
+                    auto sig = from.signature;
+                    sig.insert(std::ranges::upper_bound(sig, id), id);
+                    to = requireArchetype(sig, from, std::make_unique<Column<TComp>>(), id);
+                    to->delEdges[id] = &from;
+                }
+                auto row = moveRow(e, *to);
+                auto& column = to->template values<TComp>(to->column(id));
+                column.push_back(std::move(v));
+                return column[row];
+            }
+
+            void del(Entity e, ComponentId id) {
+                if (!has(e, id))
+                    return;
+                auto& from = *_records[e].archetype;
+                auto& to = from.delEdges[id];
+                if (!to) {
+                    auto sig = from.signature;
+                    std::erase(sig, id);
+                    to = requireArchetype(sig, from, nullptr, id);
+                    to->addEdges[id] = &from;
+                }
+                moveRow(e, *to);
+            }
+
+            // iterates every archetype that has all of `TComps`, with no per entity lookups
+            // structural changes (set of a new component, del, kill) invalidate the iteration
+            template<typename... TComps, std::invocable<Entity, TComps&...> FEach>
+            void each(FEach&& f) {
+                Signature query = { componentId<TComps>()... };
+                std::ranges::sort(query);
+                for (auto& a : allArchetypes()) {
+                    if (a->size() == 0 || !a->includes(query))
+                        continue;
+                    auto columns = std::tuple<std::vector<TComps>&...>{ a->values<TComps>(a->column(componentId<TComps>()))... };
+                    for (size_t i = 0; i < a->size(); ++i)
+                        f(a->entities[i], std::get<std::vector<TComps>&>(columns)[i]...);
+                }
+            }
+
+            /* ergonomics I */
+
+            auto findEntity(std::string_view name) -> Entity {
+                auto it = _entityNames.find(std::string(name));
+                return (it != _entityNames.end()) ? it->second : NoEntity;
+            }
+
+            auto requireEntity(std::string_view name) -> Entity {
+                if (auto e = findEntity(name); e != NoEntity)
+                    return e;
+
+                auto e = newEntity();
+                requireComponent<Name>()->set(e, { std::string(name) });
+                return _entityNames[std::string(name)] = e;
+            }
+
+            auto allComponents() { return _components | std::views::values; }
+
+            auto allSystems() { return _systems | std::views::all; }
+
+            auto findSystem(std::string_view name) -> std::shared_ptr<SystemBase> {
+                auto it = std::ranges::find_if(_systems, [&](auto s){ return s->name == name; });
+                return (it != _systems.end()) ? *it : nullptr;
+            }
+
+            // a kill is a single row removal, no matter how many components the entity has
+            void kill(Entity e) {
+                if (!record(e))
+                    return;
+                removeRow(*_records[e].archetype, _records[e].row);
+                _records[e] = { };
+            }
+    };
+
+    /* component manager forwarding */
+
+    template<typename TComp>
+    auto ComponentManager<TComp>::has(Entity e) const -> bool { return world->has(e, componentId<TComp>()); }
+    template<typename TComp>
+    void ComponentManager<TComp>::del(Entity e) { world->del(e, componentId<TComp>()); }
+
+    template<typename TComp>
+    auto ComponentManager<TComp>::get(Entity e) const -> TComp const& {
+        if (auto v = world->find<TComp>(e)) return *v;
+        throw std::out_of_range("ComponentManager::get");
+    }
+    template<typename TComp>
+    auto ComponentManager<TComp>::mut(Entity e) -> TComp& {
+        if (auto v = world->find<TComp>(e)) return *v;
+        throw std::out_of_range("ComponentManager::mut");
+    }
+    template<typename TComp>
+    void ComponentManager<TComp>::set(Entity e, TComp&& v) { world->set<TComp>(e, std::move(v)); }
+
+    template<typename TComp>
+    void ComponentManager<TComp>::with(Entity e, std::invocable<TComp&> auto chain) {
+        if (auto v = world->find<TComp>(e))
+            chain(*v); // reuse the found lookup
+    }
+
+    template<typename TComp>
+    auto ComponentManager<TComp>::str(Entity e) const -> std::string { return world->str(e, componentId<TComp>()); }
+}
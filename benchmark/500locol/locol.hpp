@@ -1,24 +1,88 @@
 #include <benchmark/benchmark.h>
+#include <thread>
 
 #include "../bench.hpp"
 
-template<BenchmarkSettings bs, typename World>
-inline void locol_bm_A(benchmark::State& state) {
+// the components the harness uses, swapped for types with the same fields to benchmark other storage
+template<typename TPosition = PositionComponent, typename TVelocity = VelocityComponent, typename TData = DataComponent>
+struct LocolComponents {
+    using Position = TPosition;
+    using Velocity = TVelocity;
+    using Data = TData;
+};
+
+// stores a default value, through `values[e]` where the manager exposes its storage and `set` where it hides it
+inline void locol_insert(auto& mgr, auto e) {
+    if constexpr (requires { mgr->values[e] = { }; })
+        mgr->values[e] = { };
+    else
+        mgr->set(e, { });
+}
+
+// the shared harness, `makeSystems(world, pos, vel, dat, delta)` registers the systems under test
+template<BenchmarkSettings bs, typename World, typename TComps, typename FSystems>
+inline void locol_bm(benchmark::State& state, FSystems&& makeSystems) {
+    BenchShape shape(state);
+    BenchMemory memory;
     TimeDelta delta = {1.0F / 60.0F};
-    std::unordered_set<uint64_t> set;
-    set.reserve(BMEntities * 1024);
-    std::vector<uint64_t> out;
-    out.reserve(BMEntities / 2);
+    HarnessSet<uint64_t> set;
+    set.reserve(shape.entities * 2);
+    HarnessVector<uint64_t> out;
+    out.reserve(shape.entities / 2);
 
     bench_or_once<bs, BenchmarkSettings::Init>(state,
     [&] {
         World world;
-        auto pos = world.template requireComponent<PositionComponent>();
-        auto vel = world.template requireComponent<VelocityComponent>();
-        auto dat = world.template requireComponent<DataComponent>();
+        auto pos = world.template requireComponent<typename TComps::Position>();
+        auto vel = world.template requireComponent<typename TComps::Velocity>();
+        auto dat = world.template requireComponent<typename TComps::Data>();
+
+        makeSystems(world, pos, vel, dat, delta);
+
+        size_t alive = 0;
+        bench_or_once<bs, BenchmarkSettings::Expand|BenchmarkSettings::Churn>(state,
+        [&] {
+            for (size_t i = 0; i < shape.entities; ++i) {
+                auto e = world.newEntity();
+                locol_insert(pos, e);
+                if (shape.hasVelocity(i))
+                    locol_insert(vel, e);
+                if (shape.hasData(i))
+                    locol_insert(dat, e);
+
+                if constexpr (bs.MainType == BenchmarkSettings::Churn)
+                    set.emplace(e);
+            }
+            alive += shape.entities;
+
+            if constexpr (bs.MainType == BenchmarkSettings::Churn) {
+                std::sample(set.begin(), set.end(),
+                    std::back_inserter(out), shape.entities / 2,
+                    m_eng
+                );
+                for (auto e : out) {
+                    world.kill(e);
+                    set.erase(e);
+                }
+                alive -= out.size();
+                out.clear();
+            }
 
+            memory.measure(alive);
+            bench_or_once<bs, BenchmarkSettings::Update>(state,
+            [&] { world.update(); });
+        });
+    });
+    shape.report(state);
+    memory.report(state);
+}
+
+// hand written joins, every system iterates one manager and probes the others
+template<BenchmarkSettings bs, typename World, typename TComps = LocolComponents<>>
+inline void locol_bm_A(benchmark::State& state) {
+    locol_bm<bs, World, TComps>(state, [](World& world, auto pos, auto vel, auto dat, TimeDelta& delta) {
         world.makeSystem("updatePosition", [=,&delta](World* w) {
-            for (auto& [e, v] : vel->values) {
+            for (auto&& [e, v] : vel->values) {
                 pos->with(e, [=](auto& p) {
                     updatePosition(p, v, delta);
                 });
@@ -26,50 +90,66 @@ inline void locol_bm_A(benchmark::State& state) {
         });
 
         world.makeSystem("updateComponents", [=](World* w) {
-            for (auto& [e, d] : dat->values) {
+            for (auto&& [e, d] : dat->values) {
                 if (pos->values.contains(e) && vel->values.contains(e)) {
                     auto& p = pos->values[e];
                     auto& v = vel->values[e];
-                    
+                
                     updateComponents(p, v, d);
                 }
             }
         });
 
         world.makeSystem("updateData", [=,&delta](World* w) {
-            for (auto& [e, d] : dat->values) {
+            for (auto&& [e, d] : dat->values) {
                 updateData(d, delta);
             }
         });
+    });
+}
 
-        bench_or_once<bs, BenchmarkSettings::Expand|BenchmarkSettings::Churn>(state,
-        [&] {
-            for (size_t i = 0; i < BMEntities; ++i) {
-                auto e = world.newEntity();
-                pos->values[e] = { };
-                if ((i & 3) == 0)
-                    vel->values[e] = { };
-                if ((i & 8) == 0)
-                    dat->values[e] = { };
+// multi-component queries, driven by the smallest manager
+template<BenchmarkSettings bs, typename World, typename TComps = LocolComponents<>>
+inline void locol_bm_Q(benchmark::State& state) {
+    locol_bm<bs, World, TComps>(state, [](World& world, auto pos, auto vel, auto dat, TimeDelta& delta) {
+        world.makeSystem("updatePosition", [&delta](World* w) {
+            for (auto [e, p, v] : w->template query<typename TComps::Position, typename TComps::Velocity const>())
+                updatePosition(p, v, delta);
+        });
 
-                if constexpr (bs.MainType == BenchmarkSettings::Churn)
-                    set.emplace(e);
-            }
+        world.makeSystem("updateComponents", [](World* w) {
+            for (auto [e, p, v, d] : w->template query<typename TComps::Position, typename TComps::Velocity, typename TComps::Data>())
+                updateComponents(p, v, d);
+        });
 
-            if constexpr (bs.MainType == BenchmarkSettings::Churn) {
-                std::sample(set.begin(), set.end(),
-                    std::back_inserter(out), BMEntities / 2,
-                    m_eng
-                );
-                for (auto e : out) {
-                    world.kill(e);
-                    set.erase(e);
-                }
-                out.clear();
-            }
+        world.makeSystem("updateData", [&delta](World* w) {
+            for (auto [e, d] : w->template query<typename TComps::Data>())
+                updateData(d, delta);
+        });
+    });
+}
 
-            bench_or_once<bs, BenchmarkSettings::Update>(state,
-            [&] { world.update(); });
+// data parallel queries on every hardware thread, updateComponents stays serial because it shares an rng
+template<BenchmarkSettings bs, typename World, typename TComps = LocolComponents<>>
+inline void locol_bm_P(benchmark::State& state) {
+    locol_bm<bs, World, TComps>(state, [](World& world, auto pos, auto vel, auto dat, TimeDelta& delta) {
+        world.useThreads(std::thread::hardware_concurrency());
+
+        world.makeSystem("updatePosition", [&delta](World* w) {
+            w->template query<typename TComps::Position, typename TComps::Velocity const>().par([&](auto e, auto& p, auto& v) {
+                updatePosition(p, v, delta);
+            });
+        });
+
+        world.makeSystem("updateComponents", [](World* w) {
+            for (auto [e, p, v, d] : w->template query<typename TComps::Position, typename TComps::Velocity, typename TComps::Data>())
+                updateComponents(p, v, d);
+        });
+
+        world.makeSystem("updateData", [&delta](World* w) {
+            w->template query<typename TComps::Data>().par([&](auto e, auto& d) {
+                updateData(d, delta);
+            });
         });
     });
 }
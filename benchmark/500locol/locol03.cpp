@@ -5,11 +5,13 @@ template<BenchmarkSettings bs>
 static void locol03_A(benchmark::State& state) {
     using namespace dsecs03;
 
+    BenchShape shape(state);
+    BenchMemory memory;
     TimeDelta delta = {1.0F / 60.0F};
     //std::unordered_set<uint64_t> set;
-    //set.reserve(BMEntities * 1024);
+    //set.reserve(shape.entities * 2);
     //std::vector<uint64_t> out;
-    //out.reserve(BMEntities / 2);
+    //out.reserve(shape.entities / 2);
 
     bench_or_once<bs, BenchmarkSettings::Init>(state,
     [&] {
@@ -45,23 +47,28 @@ static void locol03_A(benchmark::State& state) {
             }
         });
 
+        size_t alive = 0;
         bench_or_once<bs, BenchmarkSettings::Expand>(state,
         [&] {
-            for (size_t i = 0; i < BMEntities; ++i) {
+            for (size_t i = 0; i < shape.entities; ++i) {
                 auto e = world.newEntity();
                 pos->values[e] = { };
-                if ((i & 3) == 0)
+                if (shape.hasVelocity(i))
                     vel->values[e] = { };
-                if ((i & 8) == 0)
+                if (shape.hasData(i))
                     dat->values[e] = { };
             }
+            alive += shape.entities;
 
+            memory.measure(alive);
             bench_or_once<bs, BenchmarkSettings::Update>(state,
             [&] { world.update(); });
         });
     });
+    shape.report(state);
+    memory.report(state);
 }
 
-BENCHMARK(locol03_A<BsUpdate>);
-BENCHMARK(locol03_A<BsInit>);
-BENCHMARK(locol03_A<BsExpand>);//->(BMChurnIter);
+BENCHMARK(locol03_A<BsUpdate>)->Apply(BMScaling);
+BENCHMARK(locol03_A<BsInit>)->Apply(BMScaling);
+BENCHMARK(locol03_A<BsExpand>)->Apply(BMScaling);//->(BMChurnIter);
@@ -7,7 +7,7 @@ static void locol0e_A(benchmark::State& state) {
     locol_bm_A<bs, dsecs0e::World>(state);
 }
 
-BENCHMARK(locol0e_A<BsUpdate>);
-BENCHMARK(locol0e_A<BsInit>);
-BENCHMARK(locol0e_A<BsExpand>);//->(BMChurnIter);
-BENCHMARK(locol0e_A<BsChurn>);//->(BMChurnIter);
+BENCHMARK(locol0e_A<BsUpdate>)->Apply(BMScaling);
+BENCHMARK(locol0e_A<BsInit>)->Apply(BMScaling);
+BENCHMARK(locol0e_A<BsExpand>)->Apply(BMScaling);//->(BMChurnIter);
+BENCHMARK(locol0e_A<BsChurn>)->Apply(BMScaling);//->(BMChurnIter);
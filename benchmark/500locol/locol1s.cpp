@@ -7,7 +7,7 @@ static void locol1s_A(benchmark::State& state) {
     locol_bm_A<bs, dsecs1s::World>(state);
 }
 
-BENCHMARK(locol1s_A<BsUpdate>);
-BENCHMARK(locol1s_A<BsInit>);
-BENCHMARK(locol1s_A<BsExpand>);//->(BMChurnIter);
-BENCHMARK(locol1s_A<BsChurn>);//->(BMChurnIter);
+BENCHMARK(locol1s_A<BsUpdate>)->Apply(BMScaling);
+BENCHMARK(locol1s_A<BsInit>)->Apply(BMScaling);
+BENCHMARK(locol1s_A<BsExpand>)->Apply(BMScaling);//->(BMChurnIter);
+BENCHMARK(locol1s_A<BsChurn>)->Apply(BMScaling);//->(BMChurnIter);
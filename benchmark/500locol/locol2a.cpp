@@ -0,0 +1,32 @@
+#include "locol.hpp"
+#include "2a_archetypes/dsecs_2a.hpp"
+
+template<BenchmarkSettings bs>
+static void locol2a_A(benchmark::State& state) {
+    using namespace dsecs2a;
+
+    locol_bm<bs, World, LocolComponents<>>(state, [](World& world, auto pos, auto vel, auto dat, TimeDelta& delta) {
+        world.makeSystem("updatePosition", [=,&delta](World* w) {
+            w->each<PositionComponent, VelocityComponent>([=](Entity e, auto& p, auto& v) {
+                updatePosition(p, v, delta);
+            });
+        });
+
+        world.makeSystem("updateComponents", [=](World* w) {
+            w->each<PositionComponent, VelocityComponent, DataComponent>([=](Entity e, auto& p, auto& v, auto& d) {
+                updateComponents(p, v, d);
+            });
+        });
+
+        world.makeSystem("updateData", [=,&delta](World* w) {
+            w->each<DataComponent>([=](Entity e, auto& d) {
+                updateData(d, delta);
+            });
+        });
+    });
+}
+
+BENCHMARK(locol2a_A<BsUpdate>)->Apply(BMScaling);
+BENCHMARK(locol2a_A<BsInit>)->Apply(BMScaling);
+BENCHMARK(locol2a_A<BsExpand>)->Apply(BMScaling);//->(BMChurnIter);
+BENCHMARK(locol2a_A<BsChurn>)->Apply(BMScaling);//->(BMChurnIter);
@@ -7,7 +7,7 @@ static void locol9z_A(benchmark::State& state) {
     locol_bm_A<bs, dsecs9z::World>(state);
 }
 
-BENCHMARK(locol9z_A<BsUpdate>);
-BENCHMARK(locol9z_A<BsInit>);
-BENCHMARK(locol9z_A<BsExpand>);//->(BMChurnIter);
-BENCHMARK(locol9z_A<BsChurn>);//->(BMChurnIter);
+BENCHMARK(locol9z_A<BsUpdate>)->Apply(BMScaling);
+BENCHMARK(locol9z_A<BsInit>)->Apply(BMScaling);
+BENCHMARK(locol9z_A<BsExpand>)->Apply(BMScaling);//->(BMChurnIter);
+BENCHMARK(locol9z_A<BsChurn>)->Apply(BMScaling);//->(BMChurnIter);
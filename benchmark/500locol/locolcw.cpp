@@ -1,4 +1,5 @@
 #include <benchmark/benchmark.h>
+#include <cstring>
 #include "locol.hpp"
 #include "dsecs.hpp"
 
@@ -7,7 +8,385 @@ static void locolcw_A(benchmark::State& state) {
     locol_bm_A<bs, dsecs::World>(state);
 }
 
-BENCHMARK(locolcw_A<BsUpdate>);
-BENCHMARK(locolcw_A<BsInit>);
-BENCHMARK(locolcw_A<BsExpand>);//->(BMChurnIter);
-BENCHMARK(locolcw_A<BsChurn>);//->(BMChurnIter);
+BENCHMARK(locolcw_A<BsUpdate>)->Apply(BMScaling);
+BENCHMARK(locolcw_A<BsInit>)->Apply(BMScaling);
+BENCHMARK(locolcw_A<BsExpand>)->Apply(BMScaling);//->(BMChurnIter);
+BENCHMARK(locolcw_A<BsChurn>)->Apply(BMScaling);//->(BMChurnIter);
+
+template<BenchmarkSettings bs>
+static void locolcw_Q(benchmark::State& state) {
+    locol_bm_Q<bs, dsecs::World>(state);
+}
+
+BENCHMARK(locolcw_Q<BsUpdate>)->Apply(BMScaling);
+
+template<BenchmarkSettings bs>
+static void locolcw_P(benchmark::State& state) {
+    locol_bm_P<bs, dsecs::World>(state);
+}
+
+BENCHMARK(locolcw_P<BsUpdate>)->Apply(BMScaling);
+
+// the same components kept in flat maps, head to head with the sparse sets above and the node maps of locol9z
+struct FlatPositionComponent : PositionComponent { };
+struct FlatVelocityComponent : VelocityComponent { };
+struct FlatDataComponent : DataComponent { };
+
+template<> struct dsecs::StoragePolicy<FlatPositionComponent> { using type = FlatStorage; };
+template<> struct dsecs::StoragePolicy<FlatVelocityComponent> { using type = FlatStorage; };
+template<> struct dsecs::StoragePolicy<FlatDataComponent> { using type = FlatStorage; };
+
+using FlatComponents = LocolComponents<FlatPositionComponent, FlatVelocityComponent, FlatDataComponent>;
+
+template<BenchmarkSettings bs>
+static void locolcw_FA(benchmark::State& state) {
+    locol_bm_A<bs, dsecs::World, FlatComponents>(state);
+}
+
+BENCHMARK(locolcw_FA<BsUpdate>)->Apply(BMScaling);
+BENCHMARK(locolcw_FA<BsInit>)->Apply(BMScaling);
+BENCHMARK(locolcw_FA<BsExpand>)->Apply(BMScaling);
+BENCHMARK(locolcw_FA<BsChurn>)->Apply(BMScaling);
+
+template<BenchmarkSettings bs>
+static void locolcw_FQ(benchmark::State& state) {
+    locol_bm_Q<bs, dsecs::World, FlatComponents>(state);
+}
+
+BENCHMARK(locolcw_FQ<BsUpdate>)->Apply(BMScaling);
+
+struct SoaPositionComponent : PositionComponent { };
+struct SoaVelocityComponent : VelocityComponent { };
+
+template<> struct dsecs::SoaLayout<SoaPositionComponent> {
+    static constexpr auto fields = std::tuple{ &SoaPositionComponent::x, &SoaPositionComponent::y };
+    struct Ref { float& x; float& y; };
+};
+template<> struct dsecs::SoaLayout<SoaVelocityComponent> {
+    static constexpr auto fields = std::tuple{ &SoaVelocityComponent::x, &SoaVelocityComponent::y };
+    struct Ref { float& x; float& y; };
+};
+
+// queries over struct of arrays positions and velocities
+template<BenchmarkSettings bs>
+static void locolcw_S(benchmark::State& state) {
+    using namespace dsecs;
+
+    BenchShape shape(state);
+    TimeDelta delta = {1.0F / 60.0F};
+
+    bench_or_once<bs, BenchmarkSettings::Init>(state,
+    [&] {
+        World world;
+        auto pos = world.template requireComponent<SoaPositionComponent>();
+        auto vel = world.template requireComponent<SoaVelocityComponent>();
+        auto dat = world.template requireComponent<DataComponent>();
+
+        world.makeSystem("updatePosition", [&delta](World* w) {
+            for (auto [e, p, v] : w->query<SoaPositionComponent, SoaVelocityComponent const>())
+                updatePosition(p, v, delta);
+        });
+
+        world.makeSystem("updateComponents", [](World* w) {
+            for (auto [e, p, v, d] : w->query<SoaPositionComponent const, SoaVelocityComponent, DataComponent>())
+                updateComponents(p, v, d);
+        });
+
+        world.makeSystem("updateData", [&delta](World* w) {
+            for (auto [e, d] : w->query<DataComponent>())
+                updateData(d, delta);
+        });
+
+        bench_or_once<bs, BenchmarkSettings::Expand>(state,
+        [&] {
+            for (size_t i = 0; i < shape.entities; ++i) {
+                auto e = world.newEntity();
+                pos->set(e, { });
+                if (shape.hasVelocity(i))
+                    vel->set(e, { });
+                if (shape.hasData(i))
+                    dat->set(e, { });
+            }
+
+            bench_or_once<bs, BenchmarkSettings::Update>(state,
+            [&] { world.update(); });
+        });
+    });
+    shape.report(state);
+}
+
+BENCHMARK(locolcw_S<BsUpdate>)->Apply(BMScaling);
+BENCHMARK(locolcw_S<BsExpand>)->Apply(BMScaling);
+
+// integrating every entity's position, per entity or over contiguous batches with the reference kernels
+// every entity has both components and they are filled in the same order, so a batch is the whole array
+template<bool batched, typename TPosition, typename TVelocity>
+static void locolcw_K(benchmark::State& state) {
+    using namespace dsecs;
+
+    TimeDelta delta = {1.0F / 60.0F};
+    World world;
+    auto pos = world.template requireComponent<TPosition>();
+    auto vel = world.template requireComponent<TVelocity>();
+
+    if constexpr (batched)
+        world.template makeBatchSystem<TPosition, TVelocity const>("updatePositions", [&delta](auto es, auto ps, auto vs) {
+            updatePositions(ps, vs, delta);
+        });
+    else
+        world.template makeSystem<TPosition, TVelocity const>("updatePosition", [&delta](auto e, auto&& p, auto const& v) {
+            updatePosition(p, v, delta);
+        });
+
+    for (size_t i = 0; i < BMEntities; ++i) {
+        auto e = world.newEntity();
+        pos->set(e, { });
+        vel->set(e, { 1.0F, 2.0F });
+    }
+
+    for (auto _ : state)
+        world.update();
+    state.SetItemsProcessed(state.iterations() * BMEntities);
+}
+
+BENCHMARK(locolcw_K<false, PositionComponent, VelocityComponent>);
+BENCHMARK(locolcw_K<true, PositionComponent, VelocityComponent>);
+BENCHMARK(locolcw_K<false, SoaPositionComponent, SoaVelocityComponent>);
+BENCHMARK(locolcw_K<true, SoaPositionComponent, SoaVelocityComponent>);
+
+// spawning a wave into an empty world with the bulk apis, against making and setting one entity at a time
+// unlike the shared Expand harness the world starts over each time, so growing a huge world doesn't dominate
+// with an arena the world's memory is taken back all at once rather than freed piece by piece
+template<BenchmarkSettings bs, bool bulk, bool arena = false>
+static void locolcw_X(benchmark::State& state) {
+    using namespace dsecs;
+
+    std::vector<Entity> some;
+    some.reserve(BMEntities);
+    LevelArena level(64 * 1024 * 1024);
+
+    bench_or_once<bs, BenchmarkSettings::Expand>(state,
+    [&] {
+        {
+            World world(arena ? &level : std::pmr::get_default_resource());
+            auto pos = world.template requireComponent<PositionComponent>();
+            auto vel = world.template requireComponent<VelocityComponent>();
+            auto dat = world.template requireComponent<DataComponent>();
+
+            if constexpr (bulk) {
+                auto es = world.newEntities(BMEntities);
+                pos->setRange(es);
+                for (size_t i = 0; i < es.size(); i += 4)
+                    some.push_back(es[i]);
+                vel->setRange(some);
+                some.clear();
+                for (size_t i = 0; i < es.size(); ++i)
+                    if ((i & 8) == 0)
+                        some.push_back(es[i]);
+                dat->setRange(some);
+                some.clear();
+            } else {
+                for (size_t i = 0; i < BMEntities; ++i) {
+                    auto e = world.newEntity();
+                    pos->set(e, { });
+                    if ((i & 3) == 0)
+                        vel->set(e, { });
+                    if ((i & 8) == 0)
+                        dat->set(e, { });
+                }
+            }
+        }
+        if constexpr (arena)
+            level.release();
+    });
+}
+
+BENCHMARK(locolcw_X<BsExpand, false>);
+BENCHMARK(locolcw_X<BsExpand, true>);
+BENCHMARK(locolcw_X<BsExpand, false, true>);
+BENCHMARK(locolcw_X<BsExpand, true, true>);
+
+// churn that kills half the world each time, one entity at a time against a single batched kill
+// the world is refilled in bulk first, so it hovers around twice the entities spawned each time
+template<BenchmarkSettings bs, bool batched>
+static void locolcw_C(benchmark::State& state) {
+    using namespace dsecs;
+
+    World world;
+    auto pos = world.template requireComponent<PositionComponent>();
+    auto vel = world.template requireComponent<VelocityComponent>();
+    auto dat = world.template requireComponent<DataComponent>();
+    std::vector<Entity> out;
+    out.reserve(BMEntities);
+
+    bench_or_once<bs, BenchmarkSettings::Churn>(state,
+    [&] {
+        auto es = world.newEntities(BMEntities);
+        pos->setRange(es);
+        vel->setRange(std::span(es).first(es.size() / 4));
+        dat->setRange(std::span(es).last(es.size() / 2));
+
+        std::ranges::sample(world.allEntities(), std::back_inserter(out), BMEntities, m_eng);
+        if constexpr (batched)
+            world.kill(out);
+        else
+            for (auto e : out)
+                world.kill(e);
+        out.clear();
+    });
+}
+
+BENCHMARK(locolcw_C<BsChurn, false>);
+BENCHMARK(locolcw_C<BsChurn, true>);
+
+// marks half the entities and updates only those, with the marker as tag bits against a dense empty component
+struct FrozenTag { };
+struct FrozenDense { using storage = dsecs::DenseStorage; };
+
+template<BenchmarkSettings bs, typename TMarker>
+static void locolcw_T(benchmark::State& state) {
+    using namespace dsecs;
+    TimeDelta delta = {1.0F / 60.0F};
+
+    World world;
+    auto pos = world.template requireComponent<PositionComponent>();
+    auto vel = world.template requireComponent<VelocityComponent>();
+    auto mark = world.template requireComponent<TMarker>();
+    auto es = world.newEntities(BMEntities);
+    pos->setRange(es);
+    vel->setRange(es);
+    for (size_t i = 0; i < es.size(); i += 2)
+        mark->set(es[i], {});
+
+    bench_or_once<bs, BenchmarkSettings::Update>(state,
+    [&] {
+        for (auto [e, p, v, m] : world.query<PositionComponent, VelocityComponent const, TMarker const>())
+            updatePosition(p, v, delta);
+    });
+}
+
+BENCHMARK(locolcw_T<BsUpdate, FrozenTag>);
+BENCHMARK(locolcw_T<BsUpdate, FrozenDense>);
+
+// counting the entities with both of two markers, 64 at a time
+struct PlayerTag { };
+
+static void locolcw_TC(benchmark::State& state) {
+    using namespace dsecs;
+
+    World world;
+    auto es = world.newEntities(BMEntities);
+    auto frozen = world.requireComponent<FrozenTag>();
+    auto player = world.requireComponent<PlayerTag>();
+    for (size_t i = 0; i < es.size(); ++i) {
+        if (i % 2) frozen->set(es[i]);
+        if (i % 3) player->set(es[i]);
+    }
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(world.countTagged<FrozenTag, PlayerTag>());
+}
+
+BENCHMARK(locolcw_TC);
+
+// replication that packs positions into a packet, after a few percent of them were written, sending all of them or
+// only the changed ones
+template<BenchmarkSettings bs, bool changed>
+static void locolcw_D(benchmark::State& state) {
+    using namespace dsecs;
+    using TTerm = std::conditional_t<changed, Changed<PositionComponent const>, PositionComponent const>;
+
+    World world;
+    auto pos = world.template requireComponent<PositionComponent>();
+    auto es = world.newEntities(BMEntities);
+    pos->setRange(es);
+    std::vector<std::byte> packet;
+
+    size_t next = 0;
+    world.makeSystem("move", [&](World*) {
+        for (size_t i = 0; i < BMEntities / 20; ++i, next = (next + 7) % BMEntities)
+            pos->mut(es[next]).x += 1.0F;
+    });
+    world.template makeSystem<TTerm>("replicate", [&](Entity e, auto const& p) {
+        auto at = packet.size();
+        packet.resize(at + sizeof(e) + sizeof(p));
+        std::memcpy(packet.data() + at, &e, sizeof(e));
+        std::memcpy(packet.data() + at + sizeof(e), &p, sizeof(p));
+    });
+
+    bench_or_once<bs, BenchmarkSettings::Update>(state,
+    [&] {
+        packet.clear();
+        world.update();
+        benchmark::DoNotOptimize(packet.data());
+    });
+}
+
+BENCHMARK(locolcw_D<BsUpdate, false>);
+BENCHMARK(locolcw_D<BsUpdate, true>);
+
+// keeping an external broadphase in step with the positions while a few percent of entities come and go each frame,
+// by diffing against every position each frame or by observing their adds and removes
+template<BenchmarkSettings bs, bool observed>
+static void locolcw_O(benchmark::State& state) {
+    using namespace dsecs;
+
+    World world;
+    auto pos = world.template requireComponent<PositionComponent>();
+    pos->setRange(world.newEntities(BMEntities));
+    std::unordered_set<Entity> broadphase;
+    std::vector<Entity> out;
+
+    if constexpr (observed) {
+        broadphase.insert(pos->values.dense.begin(), pos->values.dense.end());
+        world.template onAdd<PositionComponent>([&](auto es) { broadphase.insert(es.begin(), es.end()); });
+        world.template onRemove<PositionComponent>([&](auto es) {
+            for (auto e : es)
+                broadphase.erase(e);
+        });
+    } else
+        world.makeSystem("poll", [&](World*) {
+            std::erase_if(broadphase, [&](Entity e) { return !pos->has(e); });
+            broadphase.insert(pos->values.dense.begin(), pos->values.dense.end());
+        });
+
+    bench_or_once<bs, BenchmarkSettings::Update>(state,
+    [&] {
+        std::ranges::sample(world.allEntities(), std::back_inserter(out), BMEntities / 50, m_eng);
+        world.kill(out);
+        out.clear();
+        pos->setRange(world.newEntities(BMEntities / 50));
+        world.update();
+    });
+}
+
+BENCHMARK(locolcw_O<BsUpdate, false>);
+BENCHMARK(locolcw_O<BsUpdate, true>);
+
+// spawning and killing uniquely named entities, each looked up by name a few times while alive
+static void locolcw_N(benchmark::State& state) {
+    using namespace dsecs;
+
+    World world;
+    std::vector<std::string> names(BMEntities / 16);
+    std::vector<Entity> es;
+    size_t next = 0;
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        for (auto& n : names)
+            n = "wandering_npc_" + std::to_string(next++);
+        state.ResumeTiming();
+
+        for (auto& n : names)
+            es.push_back(world.requireEntity(n));
+        for (int k = 0; k < 4; ++k)
+            for (auto& n : names)
+                benchmark::DoNotOptimize(world.findEntity(std::string_view(n)));
+        world.kill(es);
+        es.clear();
+    }
+    state.counters["named"] = double(world.namedEntities());
+}
+
+BENCHMARK(locolcw_N);
@@ -1,9 +1,14 @@
 #include <random>
+#include <span>
+#include <tuple>
 #include <unordered_set>
 #include "compat/format"
+#include "memory.hpp"
 
-constexpr size_t BMEntities = 16 * 1024;
+constexpr size_t BMEntities = 16 * 1024; // for the benchmarks of a single feature, the suites scale, see BMScaling
 constexpr size_t BMChurnIter = 20;
+constexpr int64_t BMMinEntities = 1 << 10;
+constexpr int64_t BMMaxEntities = 16 << 20;
 
 using TimeDelta = double;
 
@@ -30,18 +35,57 @@ struct DataComponent {
 };
 
 
-inline void updatePosition(PositionComponent& position, const VelocityComponent& direction, TimeDelta dt) {
+// positions may be proxies (e.g. from struct of arrays storage), so these take any reference with the fields
+inline void updatePosition(auto&& position, const auto& direction, TimeDelta dt) {
     position.x += direction.x * dt;
     position.y += direction.y * dt;
 }
 
+// the reference batch kernel, fixed width blocks are gathered into locals the compiler can keep in vector registers
+// (they can't alias the spans, so no runtime overlap checks are needed), the tail that doesn't fill a block is scalar
+constexpr size_t SimdLanes = 8;
+
+inline void integrate(std::span<float> xs, std::span<float const> vs, float dt) {
+    size_t i = 0;
+    for (; i + SimdLanes <= xs.size(); i += SimdLanes) {
+        float x[SimdLanes], v[SimdLanes];
+        for (size_t l = 0; l < SimdLanes; ++l) { x[l] = xs[i + l]; v[l] = vs[i + l]; }
+        for (size_t l = 0; l < SimdLanes; ++l) x[l] += v[l] * dt;
+        for (size_t l = 0; l < SimdLanes; ++l) xs[i + l] = x[l];
+    }
+    for (; i < xs.size(); ++i)
+        xs[i] += vs[i] * dt;
+}
+
+// dt is narrowed once up front, keeping the lanes in float rather than widening every multiply to double
+inline void updatePositions(std::span<PositionComponent> ps, std::span<VelocityComponent const> vs, TimeDelta dt) {
+    auto fdt = static_cast<float>(dt);
+    size_t i = 0;
+    for (; i + SimdLanes <= ps.size(); i += SimdLanes) {
+        PositionComponent p[SimdLanes];
+        VelocityComponent v[SimdLanes];
+        for (size_t l = 0; l < SimdLanes; ++l) { p[l] = ps[i + l]; v[l] = vs[i + l]; }
+        for (size_t l = 0; l < SimdLanes; ++l) { p[l].x += v[l].x * fdt; p[l].y += v[l].y * fdt; }
+        for (size_t l = 0; l < SimdLanes; ++l) ps[i + l] = p[l];
+    }
+    for (; i < ps.size(); ++i)
+        updatePosition(ps[i], vs[i], fdt);
+}
+
+// struct of arrays positions come as a span per field, each one streams on its own
+inline void updatePositions(std::tuple<std::span<float>, std::span<float>> ps,
+    std::tuple<std::span<float const>, std::span<float const>> vs, TimeDelta dt) {
+    integrate(std::get<0>(ps), std::get<0>(vs), static_cast<float>(dt));
+    integrate(std::get<1>(ps), std::get<1>(vs), static_cast<float>(dt));
+}
+
 static std::random_device m_rd;
 static std::mt19937 m_eng;
 inline int random(int min, int max) {
     std::uniform_int_distribution<int> distr(min, max);
     return distr(m_eng);
 }
-inline void updateComponents(PositionComponent& position, VelocityComponent& direction, DataComponent& data) {
+inline void updateComponents(const auto& position, auto&& direction, DataComponent& data) {
     if ((data.thingy % 10) == 0) {
         if (position.x > position.y) {
             direction.x = static_cast<float>(random(-5, 5));
@@ -79,13 +123,77 @@ static constexpr inline BenchmarkSettings::EMainType operator|(BenchmarkSettings
 template<BenchmarkSettings bs, BenchmarkSettings::EMainType type, typename FNRun>
 static inline void bench_or_once(benchmark::State& state, FNRun&& run) {
     if constexpr (((int)bs.MainType & (int)type)) {
+        auto before = bm_memory::allocations.load(std::memory_order_relaxed);
         for (auto _ : state)
             run();
+        bm_memory::timed += bm_memory::allocations.load(std::memory_order_relaxed) - before;
     } else {
         run();
     }
 }
 
+// one point of the scaling matrix, how many entities each iteration makes or updates and how many have each component
+// every entity has a position, 1 in `velocityEvery` entities move and 1 in `dataEvery` runs of 8 entities carry data
+struct BenchShape {
+    size_t entities = BMEntities;
+    size_t velocityEvery = 4;
+    size_t dataEvery = 2;
+
+    BenchShape() = default;
+    explicit BenchShape(benchmark::State const& state)
+        : entities(state.range(0)), velocityEvery(state.range(1)), dataEvery(state.range(2)) { }
+
+    auto hasVelocity(size_t i) const -> bool { return i % velocityEvery == 0; }
+    auto hasData(size_t i) const -> bool { return (i / 8) % dataEvery == 0; }
+
+    // entities per second, so the counts plot as scaling curves
+    void report(benchmark::State& state) const {
+        state.SetItemsProcessed(int64_t(state.iterations() * entities));
+    }
+};
+
+// the harness's own sets and vectors, kept out of what the library under test is charged for
+template<typename T>
+using HarnessSet = std::unordered_set<T, std::hash<T>, std::equal_to<T>, Uncounted<T>>;
+template<typename T>
+using HarnessVector = std::vector<T, Uncounted<T>>;
+
+// what a benchmark allocated: the peak over the whole run, the bytes held per live entity after the last expand or
+// churn, and the allocations made per iteration
+class BenchMemory {
+        int64_t _live = bm_memory::live, _allocations = bm_memory::allocations, _timed = bm_memory::timed;
+        int64_t _bytes = 0;
+        size_t _entities = 0;
+
+    public:
+        BenchMemory() { bm_memory::peak = _live; }
+
+        // while the world is holding `entities`
+        void measure(size_t entities) {
+            _bytes = bm_memory::live - _live;
+            _entities = entities;
+        }
+
+        // nothing to report unless counting was built in
+        void report(benchmark::State& state) const {
+            if constexpr (bm_memory::Counting) {
+                auto timed = bm_memory::timed - _timed;
+                state.counters["peak_bytes"] = double(bm_memory::peak - _live);
+                state.counters["bytes_per_entity"] = _entities ? double(_bytes) / double(_entities) : 0.0;
+                state.counters["allocs"] = benchmark::Counter(double(timed), benchmark::Counter::kAvgIterations);
+                state.counters["setup_allocs"] = double(bm_memory::allocations - _allocations - timed);
+            }
+        }
+};
+
+// entity counts from 1K to 16M, 4x apart, each dense, at the default density and sparse
+inline void BMScaling(benchmark::internal::Benchmark* b) {
+    b->ArgNames({ "entities", "velocity", "data" });
+    for (int64_t n = BMMinEntities; n <= BMMaxEntities; n *= 4)
+        for (auto [v, d] : { std::pair<int64_t, int64_t>{ 1, 1 }, { 4, 2 }, { 16, 8 } })
+            b->Args({ n, v, d });
+}
+
 constexpr BenchmarkSettings BsInit = { BenchmarkSettings::Init };
 constexpr BenchmarkSettings BsUpdate = { BenchmarkSettings::Update };
 constexpr BenchmarkSettings BsExpand = { BenchmarkSettings::Expand };
@@ -0,0 +1,35 @@
+#include "memory.hpp"
+
+#if BM_COUNT_MEMORY
+
+// every form of new and delete goes through the counting allocator, so nothing is freed with the wrong header
+
+static void* counted(size_t n, size_t align = alignof(std::max_align_t)) {
+    if (auto p = bm_memory::allocate(n ? n : 1, align))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t n) { return counted(n); }
+void* operator new[](size_t n) { return counted(n); }
+void* operator new(size_t n, std::align_val_t a) { return counted(n, size_t(a)); }
+void* operator new[](size_t n, std::align_val_t a) { return counted(n, size_t(a)); }
+void* operator new(size_t n, std::nothrow_t const&) noexcept { return bm_memory::allocate(n ? n : 1); }
+void* operator new[](size_t n, std::nothrow_t const&) noexcept { return bm_memory::allocate(n ? n : 1); }
+void* operator new(size_t n, std::align_val_t a, std::nothrow_t const&) noexcept { return bm_memory::allocate(n ? n : 1, size_t(a)); }
+void* operator new[](size_t n, std::align_val_t a, std::nothrow_t const&) noexcept { return bm_memory::allocate(n ? n : 1, size_t(a)); }
+
+void operator delete(void* p) noexcept { bm_memory::release(p); }
+void operator delete[](void* p) noexcept { bm_memory::release(p); }
+void operator delete(void* p, size_t) noexcept { bm_memory::release(p); }
+void operator delete[](void* p, size_t) noexcept { bm_memory::release(p); }
+void operator delete(void* p, std::align_val_t) noexcept { bm_memory::release(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { bm_memory::release(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { bm_memory::release(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { bm_memory::release(p); }
+void operator delete(void* p, std::nothrow_t const&) noexcept { bm_memory::release(p); }
+void operator delete[](void* p, std::nothrow_t const&) noexcept { bm_memory::release(p); }
+void operator delete(void* p, std::align_val_t, std::nothrow_t const&) noexcept { bm_memory::release(p); }
+void operator delete[](void* p, std::align_val_t, std::nothrow_t const&) noexcept { bm_memory::release(p); }
+
+#endif
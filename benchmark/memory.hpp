@@ -0,0 +1,71 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+// counting is opt in, the benchmark_memory target defines this, without it nothing is replaced or hooked and the
+// timings are those of the libraries' own allocators
+#ifndef BM_COUNT_MEMORY
+#define BM_COUNT_MEMORY 0
+#endif
+
+// every byte the benchmarks allocate through the operator new replaced in memory.cpp, each block carries a header so
+// freeing knows what it gives back
+namespace bm_memory {
+    constexpr bool Counting = BM_COUNT_MEMORY;
+
+    inline std::atomic<int64_t> live = 0, peak = 0, allocations = 0;
+    inline std::atomic<int64_t> timed = 0; // the allocations made inside the timed loops, see bench_or_once
+
+    struct Header {
+        void* raw; // what malloc returned, the block may have been moved up for alignment
+        size_t size;
+    };
+
+    inline void* allocate(size_t n, size_t align = alignof(std::max_align_t)) {
+        align = std::max(align, alignof(Header));
+        auto raw = static_cast<char*>(std::malloc(n + sizeof(Header) + align));
+        if (!raw)
+            return nullptr;
+        auto at = (reinterpret_cast<uintptr_t>(raw) + sizeof(Header) + align - 1) / align * align;
+        auto p = reinterpret_cast<char*>(at);
+        reinterpret_cast<Header*>(p)[-1] = { raw, n };
+
+        auto now = live.fetch_add(int64_t(n), std::memory_order_relaxed) + int64_t(n);
+        auto high = peak.load(std::memory_order_relaxed);
+        while (now > high && !peak.compare_exchange_weak(high, now, std::memory_order_relaxed)) { }
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        return p;
+    }
+
+    inline void release(void* p) {
+        if (!p)
+            return;
+        auto h = static_cast<Header*>(p)[-1];
+        live.fetch_sub(int64_t(h.size), std::memory_order_relaxed);
+        std::free(h.raw);
+    }
+}
+
+// for the harness's own bookkeeping, which would otherwise be counted against the library under test
+template<typename T>
+struct Uncounted {
+    using value_type = T;
+
+    Uncounted() = default;
+    template<typename U>
+    Uncounted(Uncounted<U> const&) { }
+
+    auto allocate(size_t n) -> T* {
+        if (auto p = std::malloc(n * sizeof(T)))
+            return static_cast<T*>(p);
+        throw std::bad_alloc();
+    }
+    void deallocate(T* p, size_t) { std::free(p); }
+
+    template<typename U>
+    auto operator==(Uncounted<U> const&) const -> bool { return true; }
+};
@@ -1,11 +1,34 @@
 #pragma once
 #include <memory>
 #include <unordered_map>
+#include <queue>
+#include <cmath>
+#include <chrono>
+#include <iomanip>
 #include <ranges>
 #include <vector>
 #include <string>
 #include <sstream>
 #include <concepts>
+#include <limits>
+#include <stdexcept>
+#include <array>
+#include <tuple>
+#include <algorithm>
+#include <optional>
+#include <span>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <numeric>
+#include <utility>
+#include <bitset>
+#include <memory_resource>
+#include <bit>
 
 // dead simple ecs
 namespace dsecs {
@@ -15,69 +38,1830 @@ namespace dsecs {
         { os << value } -> std::convertible_to<std::ostream &>;
     };
 
+    /* custom data structures */
+    template <typename T>
+    concept SparseKey = requires(T value) {
+        { value } -> std::convertible_to<size_t>;
+        { value == value } -> std::convertible_to<bool>;
+    };
+
+    // iteration yields `(key, value reference)` pairs by value, bind them with `auto&& [k, v]`
+    template<typename TSet, typename TRef>
+    struct SparseIterator {
+        using difference_type = std::ptrdiff_t;
+        using value_type = std::pair<typename std::remove_const_t<TSet>::key_type, TRef>;
+
+        TSet* set = nullptr;
+        size_t i = 0;
+
+        auto operator*() const -> value_type { return { set->dense[i], set->ref(i) }; }
+        auto operator++() -> SparseIterator& { ++i; return *this; }
+        auto operator++(int) -> SparseIterator { auto res = *this; ++i; return res; }
+        auto operator==(SparseIterator const& o) const -> bool { return i == o.i; }
+    };
+
+    // reserves room for `n` elements, still growing geometrically so repeated bulk inserts don't reallocate every time
+    template<typename TVec>
+    void growTo(TVec& v, size_t n) {
+        if (n > v.capacity())
+            v.reserve(std::max(n, v.capacity() * 2));
+    }
+
+    // told about every key that comes and goes, so something kept alongside a set can't miss a change to it
+    template<typename TKey>
+    struct SparseWatcher {
+        virtual ~SparseWatcher() = default;
+
+        virtual void inserted(TKey k) = 0;
+        virtual void erased(TKey k) = 0;
+        // the whole key kept at a slot, for sets that only keep slots, see BitSet
+        virtual auto keyAt(size_t slot) const -> TKey { return TKey(slot); }
+    };
+
+    // the keys of a sparse set, the values are kept parallel to dense by whatever derives from this
+    template<SparseKey TKey>
+    struct SparseIndex {
+        using key_type = TKey;
+        using TDenseIndex = uint32_t;
+        static constexpr TDenseIndex NoIndex = std::numeric_limits<TDenseIndex>::max();
+
+        std::pmr::vector<TKey> dense; // the packed keys
+        std::pmr::vector<TDenseIndex> sparse; // key slot -> index into dense, NoIndex when absent
+        SparseWatcher<TKey>* watcher = nullptr; // optional
+
+        SparseIndex(std::pmr::memory_resource* memory = std::pmr::get_default_resource())
+            : dense(memory), sparse(memory) { }
+
+        // keys are slotted by their low 32 bits, the full key in dense disambiguates any high bits (e.g. generations)
+        static constexpr auto slot(TKey k) -> size_t { return size_t(k) & 0xFFFFFFFF; }
+
+        auto size() const -> size_t { return dense.size(); }
+        auto empty() const -> bool { return dense.empty(); }
+
+        auto index(TKey k) const -> TDenseIndex {
+            auto s = slot(k);
+            if (s >= sparse.size() || sparse[s] == NoIndex || !(dense[sparse[s]] == k))
+                return NoIndex;
+            return sparse[s];
+        }
+        auto contains(TKey k) const -> bool { return index(k) != NoIndex; }
+
+    protected:
+        // grows the key arrays once for a batch of keys, rather than as each of them is inserted
+        void reserveKeys(std::span<TKey const> ks) {
+            growTo(dense, dense.size() + ks.size());
+            size_t top = 0;
+            for (auto k : ks)
+                top = std::max(top, slot(k) + 1);
+            if (top > sparse.size())
+                sparse.resize(top, NoIndex);
+        }
+
+        auto insertKey(TKey k) -> TDenseIndex {
+            auto s = slot(k);
+            if (s >= sparse.size())
+                sparse.resize(s + 1, NoIndex);
+            if (sparse[s] != NoIndex)
+                throw std::invalid_argument("SparseSet::emplace slot is held by another key");
+            sparse[s] = TDenseIndex(dense.size());
+            dense.push_back(k);
+            if (watcher)
+                watcher->inserted(k);
+            return sparse[s];
+        }
+
+        // swap-and-pop, the last key takes the place of the erased one
+        // returns the erased index so the values can follow suit, or NoIndex if the key was absent
+        auto eraseKey(TKey k) -> TDenseIndex {
+            auto i = index(k);
+            if (i == NoIndex)
+                return NoIndex;
+            dense[i] = dense.back();
+            sparse[slot(dense[i])] = i;
+            dense.pop_back();
+            sparse[slot(k)] = NoIndex;
+            if (watcher)
+                watcher->erased(k);
+            return i;
+        }
+
+        void clearKeys() {
+            if (watcher)
+                for (auto k : dense)
+                    watcher->erased(k);
+            dense.clear();
+            sparse.clear();
+        }
+    };
+
+    // the keys of a flat map, an open addressing robin hood table from the hash of a key to its index in dense
+    // where a sparse index grows with the largest key, this grows with the number of keys
+    template<SparseKey TKey>
+    struct FlatIndex {
+        using key_type = TKey;
+        using TDenseIndex = uint32_t;
+        static constexpr TDenseIndex NoIndex = std::numeric_limits<TDenseIndex>::max();
+
+        // the high bits count how far the bucket is from where its key hashed to (plus one), the low byte is more of the hash
+        // so a probe can give up, or skip a key, without looking at dense
+        struct Bucket {
+            uint32_t distAndPrint = 0; // 0 when empty
+            TDenseIndex index = NoIndex;
+        };
+        static constexpr uint32_t Dist = 1 << 8;
+
+        std::pmr::vector<TKey> dense; // the packed keys
+        std::pmr::vector<Bucket> buckets; // a power of two of them, at most 80% full
+        SparseWatcher<TKey>* watcher = nullptr; // optional
+
+        FlatIndex(std::pmr::memory_resource* memory = std::pmr::get_default_resource())
+            : dense(memory), buckets(memory) { }
+
+        auto size() const -> size_t { return dense.size(); }
+        auto empty() const -> bool { return dense.empty(); }
+
+        auto index(TKey k) const -> TDenseIndex {
+            auto b = bucketOf(k);
+            return (b != buckets.size()) ? buckets[b].index : NoIndex;
+        }
+        auto contains(TKey k) const -> bool { return index(k) != NoIndex; }
+
+    protected:
+        size_t _shift = 64; // the hash is shifted down to index buckets
+
+        static auto hash(TKey k) -> uint64_t {
+            auto h = uint64_t(k) * 0x9E3779B97F4A7C15ull; // fibonacci hashing, the high bits pick the bucket
+            return h ^ (h >> 29);
+        }
+        auto start(TKey k) const -> std::pair<uint32_t, size_t> {
+            auto h = hash(k);
+            return { Dist | uint32_t(h & 0xFF), size_t(h >> _shift) };
+        }
+        auto next(size_t b) const -> size_t { return (b + 1) & (buckets.size() - 1); }
+
+        // robin hood, a key takes the bucket of any key closer to home than it is, which then moves along
+        void place(Bucket bucket, size_t b) {
+            while (buckets[b].distAndPrint != 0) {
+                std::swap(bucket, buckets[b]);
+                bucket.distAndPrint += Dist;
+                b = next(b);
+            }
+            buckets[b] = bucket;
+        }
+
+        void rehash(size_t count) {
+            buckets.assign(count, {});
+            _shift = 64 - std::countr_zero(count);
+            for (TDenseIndex i = 0; i < dense.size(); ++i) {
+                auto [dap, b] = start(dense[i]);
+                for (; dap <= buckets[b].distAndPrint; dap += Dist)
+                    b = next(b);
+                place({ dap, i }, b);
+            }
+        }
+        void fit(size_t keys) {
+            auto count = std::max<size_t>(buckets.size(), 8);
+            while (keys * 5 > count * 4)
+                count *= 2;
+            if (count != buckets.size())
+                rehash(count);
+        }
+
+        void reserveKeys(std::span<TKey const> ks) {
+            growTo(dense, dense.size() + ks.size());
+            fit(dense.size() + ks.size());
+        }
+
+        auto insertKey(TKey k) -> TDenseIndex {
+            fit(dense.size() + 1);
+            auto [dap, b] = start(k);
+            for (; dap <= buckets[b].distAndPrint; dap += Dist, b = next(b))
+                if (buckets[b].distAndPrint == dap && dense[buckets[b].index] == k)
+                    throw std::invalid_argument("FlatIndex::insertKey key is already present");
+            auto i = TDenseIndex(dense.size());
+            dense.push_back(k);
+            place({ dap, i }, b);
+            if (watcher)
+                watcher->inserted(k);
+            return i;
+        }
+
+        // swap-and-pop like the sparse index, and backwards shift deletion to keep the table free of tombstones
+        auto eraseKey(TKey k) -> TDenseIndex {
+            auto b = bucketOf(k);
+            if (b == buckets.size())
+                return NoIndex;
+            auto i = buckets[b].index;
+            for (auto n = next(b); buckets[n].distAndPrint >= 2 * Dist; b = n, n = next(n))
+                buckets[b] = { buckets[n].distAndPrint - Dist, buckets[n].index };
+            buckets[b] = {};
+
+            if (size_t(i) + 1 != dense.size()) {
+                buckets[bucketOf(dense.back())].index = i;
+                dense[i] = dense.back();
+            }
+            dense.pop_back();
+            if (watcher)
+                watcher->erased(k);
+            return i;
+        }
+
+        void clearKeys() {
+            if (watcher)
+                for (auto k : dense)
+                    watcher->erased(k);
+            dense.clear();
+            std::ranges::fill(buckets, Bucket{});
+        }
+
+        // the bucket holding the key, or the bucket count when absent
+        auto bucketOf(TKey k) const -> size_t {
+            if (buckets.empty())
+                return 0;
+            auto [dap, b] = start(k);
+            for (;; dap += Dist, b = next(b)) {
+                auto& bucket = buckets[b];
+                if (bucket.distAndPrint == dap && dense[bucket.index] == k)
+                    return b;
+                if (bucket.distAndPrint < dap)
+                    return buckets.size();
+            }
+        }
+    };
+
+    // the values of a sparse set are packed parallel to its keys, `TIndex` finds a key's place in them
+    template<SparseKey TKey, typename TData, typename TIndex = SparseIndex<TKey>>
+    struct SparseSet : TIndex {
+        using typename TIndex::TDenseIndex;
+        using TIndex::NoIndex;
+        using TIndex::index;
+
+        std::pmr::vector<TData> data; // the packed values, parallel to dense
+
+        SparseSet(std::pmr::memory_resource* memory = std::pmr::get_default_resource())
+            : TIndex(memory), data(memory) { }
+
+        auto begin() { return SparseIterator<SparseSet, TData&>{ this, 0 }; }
+        auto end() { return SparseIterator<SparseSet, TData&>{ this, this->size() }; }
+        auto begin() const { return SparseIterator<SparseSet const, TData const&>{ this, 0 }; }
+        auto end() const { return SparseIterator<SparseSet const, TData const&>{ this, this->size() }; }
+
+        void clear() { this->clearKeys(); data.clear(); }
+        void reserve(std::span<TKey const> ks) { this->reserveKeys(ks); growTo(data, this->dense.capacity()); }
+
+        auto ref(size_t i) -> TData& { return data[i]; }
+        auto ref(size_t i) const -> TData const& { return data[i]; }
+
+        auto find(TKey k) -> TData* {
+            auto i = index(k);
+            return (i != NoIndex) ? &data[i] : nullptr;
+        }
+        auto find(TKey k) const -> TData const* {
+            auto i = index(k);
+            return (i != NoIndex) ? &data[i] : nullptr;
+        }
+
+        auto at(TKey k) -> TData& {
+            if (auto v = find(k)) return *v;
+            throw std::out_of_range("SparseSet::at");
+        }
+        auto at(TKey k) const -> TData const& {
+            if (auto v = find(k)) return *v;
+            throw std::out_of_range("SparseSet::at");
+        }
+
+        template<typename... TArgs>
+        auto emplace(TKey k, TArgs&&... args) -> TData& {
+            this->insertKey(k);
+            return data.emplace_back(std::forward<TArgs>(args)...);
+        }
+
+        auto insert_or_assign(TKey k, TData v) -> TData& {
+            if (auto it = find(k))
+                return *it = std::move(v);
+            return emplace(k, std::move(v));
+        }
+
+        auto operator[](TKey k) -> TData& {
+            if (auto it = find(k))
+                return *it;
+            return emplace(k);
+        }
+
+        auto erase(TKey k) -> size_t {
+            auto i = this->eraseKey(k);
+            if (i == NoIndex)
+                return 0;
+            if (size_t(i) + 1 != data.size())
+                data[i] = std::move(data.back());
+            data.pop_back();
+            return 1;
+        }
+    };
+
+    // a hash map, with its keys and values packed like a sparse set's
+    template<SparseKey TKey, typename TData>
+    using FlatMap = SparseSet<TKey, TData, FlatIndex<TKey>>;
+
+    // opt in to struct of arrays storage by listing the fields, and a proxy of references with the same names:
+    //   template<> struct dsecs::SoaLayout<Position> {
+    //       static constexpr auto fields = std::tuple{ &Position::x, &Position::y };
+    //       struct Ref { float& x; float& y; };
+    //   };
+    template<typename TComp>
+    struct SoaLayout;
+
+    template<typename TComp>
+    concept SoaComponent = std::is_trivially_copyable_v<TComp> && std::is_aggregate_v<TComp> && requires {
+        SoaLayout<TComp>::fields;
+        typename SoaLayout<TComp>::Ref;
+    };
+
+    // the declared types of the `N` members of an aggregate in order, read through a structured binding
+    template<size_t N, typename TRef>
+    auto soaMembers(TRef& r) {
+        static_assert(N <= 8, "SoaLayout supports up to 8 fields");
+        if constexpr (N == 1) { auto& [a] = r; return std::type_identity<std::tuple<decltype(a)>>{}; }
+        else if constexpr (N == 2) { auto& [a, b] = r; return std::type_identity<std::tuple<decltype(a), decltype(b)>>{}; }
+        else if constexpr (N == 3) { auto& [a, b, c] = r; return std::type_identity<std::tuple<decltype(a), decltype(b), decltype(c)>>{}; }
+        else if constexpr (N == 4) { auto& [a, b, c, d] = r; return std::type_identity<std::tuple<decltype(a), decltype(b), decltype(c), decltype(d)>>{}; }
+        else if constexpr (N == 5) { auto& [a, b, c, d, e] = r; return std::type_identity<std::tuple<decltype(a), decltype(b), decltype(c), decltype(d), decltype(e)>>{}; }
+        else if constexpr (N == 6) { auto& [a, b, c, d, e, f] = r; return std::type_identity<std::tuple<decltype(a), decltype(b), decltype(c), decltype(d), decltype(e), decltype(f)>>{}; }
+        else if constexpr (N == 7) { auto& [a, b, c, d, e, f, g] = r; return std::type_identity<std::tuple<decltype(a), decltype(b), decltype(c), decltype(d), decltype(e), decltype(f), decltype(g)>>{}; }
+        else if constexpr (N == 8) { auto& [a, b, c, d, e, f, g, h] = r; return std::type_identity<std::tuple<decltype(a), decltype(b), decltype(c), decltype(d), decltype(e), decltype(f), decltype(g), decltype(h)>>{}; }
+    }
+
+    template<typename TFields>
+    struct SoaColumns;
+    template<typename... TFields, typename... TOwners>
+    struct SoaColumns<std::tuple<TFields TOwners::*...>> {
+        using type = std::tuple<std::pmr::vector<TFields>...>;
+        using block = std::tuple<std::span<TFields>...>;
+        using const_block = std::tuple<std::span<TFields const>...>;
+        using refs = std::tuple<TFields&...>; // what a Ref must hold, in order
+        static constexpr size_t stride = std::min({ sizeof(TFields)... }); // the narrowest column
+
+        static auto make(std::pmr::memory_resource* memory) -> type { return type{ std::pmr::vector<TFields>(memory)... }; }
+    };
+
+    // a sparse set that splits each field of its values into a packed array of its own
+    template<SparseKey TKey, SoaComponent TComp>
+    struct SoaSet : SparseIndex<TKey> {
+        using typename SparseIndex<TKey>::TDenseIndex;
+        using SparseIndex<TKey>::NoIndex;
+        using SparseIndex<TKey>::index;
+        using Layout = SoaLayout<TComp>;
+        using Ref = typename Layout::Ref;
+        using Columns = SoaColumns<std::remove_cvref_t<decltype(Layout::fields)>>;
+        // a Ref is filled positionally, so its members must be the fields in order, fields of the same type can still
+        // be swapped unnoticed, as only their types are compared
+        static_assert(std::is_aggregate_v<Ref> && std::is_same_v<typename decltype(
+            soaMembers<std::tuple_size_v<typename Columns::refs>>(std::declval<Ref&>()))::type, typename Columns::refs>,
+            "SoaLayout::Ref must hold a reference to each of the fields, in the same order");
+
+        typename Columns::type columns; // one packed array per field, each parallel to dense
+
+        SoaSet(std::pmr::memory_resource* memory = std::pmr::get_default_resource())
+            : SparseIndex<TKey>(memory), columns(Columns::make(memory)) { }
+
+        template<size_t I>
+        auto field() -> auto& { return std::get<I>(columns); }
+
+        auto begin() { return SparseIterator<SoaSet, Ref>{ this, 0 }; }
+        auto end() { return SparseIterator<SoaSet, Ref>{ this, this->size() }; }
+        auto begin() const { return SparseIterator<SoaSet const, TComp>{ this, 0 }; }
+        auto end() const { return SparseIterator<SoaSet const, TComp>{ this, this->size() }; }
+
+        void clear() {
+            this->clearKeys();
+            std::apply([](auto&... cs) { (cs.clear(), ...); }, columns);
+        }
+        void reserve(std::span<TKey const> ks) {
+            this->reserveKeys(ks);
+            std::apply([&](auto&... cs) { (growTo(cs, this->dense.capacity()), ...); }, columns);
+        }
+
+        auto ref(size_t i) -> Ref { return std::apply([&](auto&... cs) { return Ref{ cs[i]... }; }, columns); }
+        // reading gathers a copy, there is no single place the value lives to reference
+        auto ref(size_t i) const -> TComp {
+            TComp v{};
+            eachField(*this, [&](auto f, auto& c) { v.*f = c[i]; });
+            return v;
+        }
+
+        auto at(TKey k) -> Ref {
+            if (auto i = index(k); i != NoIndex) return ref(i);
+            throw std::out_of_range("SoaSet::at");
+        }
+        auto at(TKey k) const -> TComp {
+            if (auto i = index(k); i != NoIndex) return ref(i);
+            throw std::out_of_range("SoaSet::at");
+        }
+
+        auto emplace(TKey k, TComp const& v = {}) -> Ref {
+            auto i = this->insertKey(k);
+            eachField(*this, [&](auto f, auto& c) { c.push_back(v.*f); });
+            return ref(i);
+        }
+
+        auto insert_or_assign(TKey k, TComp const& v) -> Ref {
+            auto i = index(k);
+            if (i == NoIndex)
+                return emplace(k, v);
+            eachField(*this, [&](auto f, auto& c) { c[i] = v.*f; });
+            return ref(i);
+        }
+
+        auto operator[](TKey k) -> Ref {
+            if (auto i = index(k); i != NoIndex)
+                return ref(i);
+            return emplace(k);
+        }
+
+        auto erase(TKey k) -> size_t {
+            auto i = this->eraseKey(k);
+            if (i == NoIndex)
+                return 0;
+            std::apply([&](auto&... cs) {
+                ((cs[i] = cs.back(), cs.pop_back()), ...);
+            }, columns);
+            return 1;
+        }
+
+    private:
+        template<typename TSelf, typename F>
+        static void eachField(TSelf& self, F&& f) {
+            [&]<size_t... Is>(std::index_sequence<Is...>) {
+                (f(std::get<Is>(Layout::fields), std::get<Is>(self.columns)), ...);
+            }(std::make_index_sequence<std::tuple_size_v<typename Columns::type>>{});
+        }
+    };
+
+    // a set of keys kept as one bit per key slot, for keys that carry no value
+    // set, clear and test are O(1), and whole words of 64 slots are combined and walked at once
+    // only the slot is kept, so any high bits of a key (e.g. generations) are the owner's to check
+    template<SparseKey TKey>
+    struct BitSet {
+        using key_type = TKey;
+        using Word = uint64_t;
+        using TDenseIndex = uint32_t;
+        static constexpr size_t WordBits = std::numeric_limits<Word>::digits;
+        static constexpr TDenseIndex NoIndex = std::numeric_limits<TDenseIndex>::max();
+
+        std::pmr::vector<Word> words; // slot -> bit
+        size_t count = 0;
+        SparseWatcher<TKey>* watcher = nullptr; // optional, asked for the whole key of a slot it clears
+
+        BitSet(std::pmr::memory_resource* memory = std::pmr::get_default_resource())
+            : words(memory) { }
+
+        static constexpr auto slot(TKey k) -> size_t { return size_t(k) & 0xFFFFFFFF; }
+
+        auto size() const -> size_t { return count; }
+        auto empty() const -> bool { return count == 0; }
+
+        auto test(size_t s) const -> bool { return s / WordBits < words.size() && (words[s / WordBits] >> (s % WordBits) & 1); }
+        auto contains(TKey k) const -> bool { return test(slot(k)); }
+        // there are no packed values to index, every present key answers 0
+        auto index(TKey k) const -> TDenseIndex { return contains(k) ? 0 : NoIndex; }
+
+        void reserve(std::span<TKey const> ks) {
+            size_t top = 0;
+            for (auto k : ks)
+                top = std::max(top, slot(k) / WordBits + 1);
+            if (top > words.size())
+                words.resize(top);
+        }
+
+        // returns whether the key was newly added
+        auto insert(TKey k) -> bool {
+            auto s = slot(k);
+            if (s / WordBits >= words.size())
+                words.resize(s / WordBits + 1);
+            auto bit = Word(1) << (s % WordBits);
+            if (words[s / WordBits] & bit)
+                return false;
+            words[s / WordBits] |= bit;
+            ++count;
+            if (watcher)
+                watcher->inserted(k);
+            return true;
+        }
+
+        auto erase(TKey k) -> size_t {
+            if (!contains(k))
+                return 0;
+            words[slot(k) / WordBits] &= ~(Word(1) << (slot(k) % WordBits));
+            --count;
+            if (watcher)
+                watcher->erased(k);
+            return 1;
+        }
+
+        void clear() {
+            if (watcher)
+                each([&](size_t s) { watcher->erased(watcher->keyAt(s)); });
+            words.clear();
+            count = 0;
+        }
+
+        // calls `f(slot)` for every set slot in ascending order
+        template<std::invocable<size_t> F>
+        void each(F&& f) const {
+            BitSet const* self[] = { this };
+            eachOf(self, f);
+        }
+
+        // calls `f(slot)` for every slot set in all of `sets`, intersecting them a word at a time
+        template<std::invocable<size_t> F>
+        static void eachOf(std::span<BitSet const* const> sets, F&& f) {
+            eachWord(sets, [&](size_t w, Word bits) {
+                for (; bits; bits &= bits - 1)
+                    f(w * WordBits + size_t(std::countr_zero(bits)));
+            });
+        }
+        // the slots set in all of `sets`, as a set of its own
+        static auto intersection(std::span<BitSet const* const> sets) -> BitSet {
+            BitSet res;
+            eachWord(sets, [&](size_t w, Word bits) {
+                growTo(res.words, w + 1);
+                res.words.resize(w + 1);
+                res.words[w] = bits;
+                res.count += size_t(std::popcount(bits));
+            });
+            return res;
+        }
+        static auto countOf(std::span<BitSet const* const> sets) -> size_t {
+            size_t res = 0;
+            eachWord(sets, [&](size_t, Word bits) { res += size_t(std::popcount(bits)); });
+            return res;
+        }
+
+    private:
+        template<typename F>
+        static void eachWord(std::span<BitSet const* const> sets, F&& f) {
+            if (sets.empty())
+                return;
+            auto n = std::ranges::min(sets | std::views::transform([](auto b) { return b->words.size(); }));
+            for (size_t w = 0; w < n; ++w) {
+                auto bits = ~Word(0);
+                for (auto b : sets)
+                    bits &= b->words[w];
+                if (bits)
+                    f(w, bits);
+            }
+        }
+    };
+
+    /* memory */
+
+    // a fixed budget for a level's worth of entities and components, given back all at once when the arena goes
+    // small freed blocks are pooled by size for reuse, large ones (outgrown arrays) are not, so leave room for growth
+    // like the world's structure it must only be changed from one thread at a time, running past the budget throws
+    class LevelArena final : public std::pmr::memory_resource {
+            std::unique_ptr<std::byte[]> _buffer;
+            std::pmr::monotonic_buffer_resource _arena;
+            std::pmr::unsynchronized_pool_resource _pool;
+
+            virtual auto do_allocate(size_t bytes, size_t align) -> void* override { return _pool.allocate(bytes, align); }
+            virtual void do_deallocate(void* p, size_t bytes, size_t align) override { _pool.deallocate(p, bytes, align); }
+            virtual auto do_is_equal(std::pmr::memory_resource const& o) const noexcept -> bool override { return this == &o; }
+
+        public:
+            LevelArena(size_t budget)
+                : _buffer(std::make_unique_for_overwrite<std::byte[]>(budget)), _arena(_buffer.get(), budget, std::pmr::null_memory_resource()), _pool(&_arena) { }
+
+            // takes back everything at once for the next level, nothing allocated from it may be used after
+            void release() {
+                _pool.release();
+                _arena.release();
+            }
+    };
+
+    // reuses freed blocks by size rather than returning them to the system, for worlds that live a long time
+    using PooledMemory = std::pmr::unsynchronized_pool_resource;
+
     /* entity trinity */
 
-    using Entity = uint64_t;
-    constexpr Entity NoEntity = 0;
+    // the low 32 bits index a slot that is recycled, the high 32 bits count how many times it has been
+    using Entity = uint64_t;
+    using EntityIndex = uint32_t;
+    using EntityGeneration = uint32_t;
+    constexpr Entity NoEntity = 0;
+
+    constexpr auto entityIndex(Entity e) -> EntityIndex { return EntityIndex(e); }
+    constexpr auto entityGeneration(Entity e) -> EntityGeneration { return EntityGeneration(e >> 32); }
+    constexpr auto makeEntity(EntityIndex i, EntityGeneration g) -> Entity { return (Entity(g) << 32) | i; }
+
+    /* component ids */
+
+    // a dense id per component type, handed out on first use and shared by every world in the process
+    using ComponentId = uint32_t;
+
+    inline auto nextComponentId() -> ComponentId {
+        static std::atomic<ComponentId> next = 0;
+        return next++;
+    }
+
+    template<typename TComp>
+    auto componentId() -> ComponentId {
+        static const ComponentId id = nextComponentId();
+        return id;
+    }
+
+    // the type's name as the compiler spells it, so naming managers doesn't need rtti
+    template<typename T>
+    constexpr auto typeName() -> std::string_view {
+    #if defined(_MSC_VER)
+        std::string_view f = __FUNCSIG__;
+        auto first = f.find("typeName<") + 9, last = f.rfind(">(void)");
+    #else
+        std::string_view f = __PRETTY_FUNCTION__;
+        auto first = f.find("T = ") + 4, last = f.find_first_of(";]", first);
+    #endif
+        return f.substr(first, last - first);
+    }
+
+    /* component signatures */
+
+    #ifndef DSECS_MAX_COMPONENTS
+    #define DSECS_MAX_COMPONENTS 256
+    #endif
+    constexpr size_t MaxComponents = DSECS_MAX_COMPONENTS;
+
+    // a bit per component id, set for each component an entity has
+    using Signature = std::bitset<MaxComponents>;
+
+    template<typename... TComps>
+    auto signatureOf() -> Signature {
+        Signature res;
+        (res.set(componentId<std::remove_const_t<TComps>>()), ...);
+        return res;
+    }
+
+    // the signature of every entity by index, shared by a world and its managers
+    // along with the generation each index is on, so a manager can refuse handles the world has killed
+    struct Signatures {
+        std::pmr::vector<Signature> bits;
+        std::pmr::vector<EntityGeneration> generations; // index -> the generation of its live or next entity
+
+        Signatures(std::pmr::memory_resource* memory = std::pmr::get_default_resource())
+            : bits(memory), generations(memory) { }
+
+        auto current(Entity e) const -> bool {
+            auto i = entityIndex(e);
+            return i < generations.size() ? generations[i] == entityGeneration(e) : entityGeneration(e) == 0;
+        }
+        void issue(Entity e) {
+            auto i = entityIndex(e);
+            if (i >= generations.size())
+                generations.resize(std::max<size_t>(size_t(i) + 1, generations.size() * 2));
+            generations[i] = entityGeneration(e);
+        }
+
+        auto of(EntityIndex i) const -> Signature { return (i < bits.size()) ? bits[i] : Signature{}; }
+        void set(EntityIndex i, ComponentId c, bool v) {
+            if (i >= bits.size())
+                bits.resize(size_t(i) + 1);
+            bits[i][c] = v;
+        }
+    };
+
+    /* change ticks */
+
+    // the world's clock advances after every system run, 0 is before anything changed
+    using Tick = uint32_t;
+    using Clock = std::atomic<Tick>;
+
+    /* component events */
+
+    // an entity gaining a component, having its value replaced by a set, or losing it (including by being killed)
+    enum class ComponentEvent : uint8_t { Add, Set, Remove };
+    constexpr size_t ComponentEvents = 3;
+
+    using Observer = std::function<void(std::span<Entity const>)>;
+
+    // events in the order they happened, as runs of one kind so a bulk change is handed out as a single span
+    struct EventQueue {
+        std::pmr::vector<Entity> entities;
+        std::pmr::vector<std::pair<ComponentEvent, size_t>> runs; // the kind of each run and where it ends in entities
+
+        EventQueue(std::pmr::memory_resource* memory = std::pmr::get_default_resource())
+            : entities(memory), runs(memory) { }
+
+        auto empty() const -> bool { return entities.empty(); }
+        void clear() { entities.clear(); runs.clear(); }
+
+        void push(ComponentEvent k, Entity e) {
+            entities.push_back(e);
+            if (runs.empty() || runs.back().first != k)
+                runs.emplace_back(k, entities.size());
+            else
+                runs.back().second = entities.size();
+        }
+
+        // calls `f(kind, entities)` for each run in order
+        template<std::invocable<ComponentEvent, std::span<Entity const>> F>
+        void each(F&& f) const {
+            size_t first = 0;
+            for (auto [k, last] : runs) {
+                f(k, std::span(entities).subspan(first, last - first));
+                first = last;
+            }
+        }
+    };
+
+    /* component trinity */
+
+    // watches its own storage, so the world's signatures follow however the values are changed
+    // once tracked every possible write (`mut`, `set`, `with`, a mutable query) stamps the entity with the clock's tick
+    struct ComponentManagerBase : SparseWatcher<Entity> {
+        std::string name;
+        ComponentId id = 0;
+        std::shared_ptr<Signatures> signatures; // set by the world that made this
+        std::shared_ptr<Clock> clock; // set by the world that made this, without one every write is at tick 1
+        std::pmr::vector<Tick> ticks; // entity index -> the tick of its insertion or last possible write, once tracked
+        Tick trackedFrom = 0; // nothing is stamped until something asks about changes, older values count as changed then
+        std::array<std::vector<Observer>, ComponentEvents> observers; // by event kind
+        EventQueue events, delivering; // only the kinds with observers are recorded
+        std::shared_ptr<SparseWatcher<Entity>> index; // told of every insert and erase too, for an index the world keeps over this
+
+        ComponentManagerBase(std::string_view name, std::pmr::memory_resource* memory = std::pmr::get_default_resource())
+            : name(name), ticks(memory), events(memory), delivering(memory) { }
+        virtual ~ComponentManagerBase() = default;
+
+        virtual void inserted(Entity e) override final {
+            if (signatures)
+                signatures->set(entityIndex(e), id, true);
+            touch(e);
+            record(ComponentEvent::Add, e);
+            if (index)
+                index->inserted(e);
+        }
+        virtual void erased(Entity e) override final {
+            if (signatures)
+                signatures->set(entityIndex(e), id, false);
+            if (entityIndex(e) < ticks.size())
+                ticks[entityIndex(e)] = 0;
+            record(ComponentEvent::Remove, e);
+            if (index)
+                index->erased(e);
+        }
+        // tag bits only keep the index, the generation is the one the world last issued for it
+        virtual auto keyAt(size_t slot) const -> Entity override final {
+            auto i = EntityIndex(slot);
+            return makeEntity(i, (signatures && i < signatures->generations.size()) ? signatures->generations[i] : 0);
+        }
+
+        // whether `e` is the handle the world last issued for its index, one it has killed may name another entity's slot
+        auto live(Entity e) const -> bool { return !signatures || signatures->current(e); }
+
+        // a handle the world has killed is refused, its index may already belong to another entity
+        void admit(Entity e) const {
+            if (!live(e))
+                throw std::invalid_argument("ComponentManager::set entity is dead");
+        }
+
+        void observe(ComponentEvent k, Observer f) { observers[size_t(k)].push_back(std::move(f)); }
+        void record(ComponentEvent k, Entity e) {
+            if (!observers[size_t(k)].empty())
+                events.push(k, e);
+        }
+
+        // hands the recorded events to the observers, anything they change in turn waits for the next call
+        void notify() {
+            if (events.empty())
+                return;
+            std::swap(events, delivering);
+            delivering.each([&](ComponentEvent k, std::span<Entity const> es) {
+                for (auto& f : observers[size_t(k)])
+                    f(es);
+            });
+            delivering.clear();
+        }
+
+        auto now() const -> Tick { return clock ? clock->load(std::memory_order_relaxed) : 1; }
+        void track() {
+            if (trackedFrom)
+                return;
+            trackedFrom = now();
+            // room for every entity that has this already, so stamping them never grows the ticks mid query
+            if (signatures)
+                ticks.resize(signatures->bits.size());
+        }
+
+        void touch(Entity e, Tick t) {
+            if (trackedFrom)
+                stamp(entityIndex(e), t);
+        }
+        void touch(Entity e) {
+            if (trackedFrom)
+                stamp(entityIndex(e), now());
+        }
+        void touch(std::span<Entity const> es, Tick t) {
+            if (trackedFrom)
+                for (auto e : es)
+                    stamp(entityIndex(e), t);
+        }
+
+        auto changedSince(Entity e, Tick since) const -> bool {
+            auto i = entityIndex(e);
+            return std::max((i < ticks.size()) ? ticks[i] : 0, trackedFrom) >= since;
+        }
+
+        virtual auto has(Entity e) const -> bool = 0;
+        virtual void del(Entity e) = 0;
+        virtual void delMany(std::span<Entity const> es) = 0; // one dispatch for a whole batch
+
+        virtual auto str(Entity e) const -> std::string = 0;
+
+    private:
+        void stamp(EntityIndex i, Tick t) {
+            if (i >= ticks.size())
+                ticks.resize(std::max(size_t(i) + 1, ticks.size() * 2));
+            ticks[i] = t;
+        }
+    };
+
+    /* storage policies */
+
+    // how a component's manager keeps its values, a component picks one with a `using storage = ...` member or by
+    // specializing StoragePolicy, otherwise components with a SoaLayout are split into arrays, empty ones are tags,
+    // and the rest are dense
+    struct DenseStorage {
+        template<typename TComp> using container = SparseSet<Entity, TComp>;
+    };
+    struct FlatStorage {
+        template<typename TComp> using container = FlatMap<Entity, TComp>;
+    };
+    struct SoaStorage {
+        template<typename TComp> using container = SoaSet<Entity, TComp>;
+    };
+    struct TagStorage {
+        template<typename TComp> using container = BitSet<Entity>;
+    };
+
+    template<typename TComp>
+    concept HasStorage = requires { typename TComp::storage; };
+
+    template<typename TComp>
+    struct StoragePolicy {
+        using type = DenseStorage;
+    };
+    template<HasStorage TComp>
+    struct StoragePolicy<TComp> {
+        using type = typename TComp::storage;
+    };
+    template<SoaComponent TComp> requires (!HasStorage<TComp>)
+    struct StoragePolicy<TComp> {
+        using type = SoaStorage;
+    };
+    template<typename TComp> requires (std::is_empty_v<TComp> && !HasStorage<TComp> && !SoaComponent<TComp>)
+    struct StoragePolicy<TComp> {
+        using type = TagStorage;
+    };
+
+    // an empty component, kept as a bit per entity
+    template<typename TComp>
+    concept TagComponent = std::is_same_v<typename StoragePolicy<TComp>::type, TagStorage>;
+
+    // the manager for packed values handed out by reference, DenseStorage and FlatStorage
+    template<typename TComp, typename TPolicy = typename StoragePolicy<TComp>::type>
+    struct ComponentManager final : ComponentManagerBase {
+        using container = typename TPolicy::template container<TComp>;
+        container values; // the actual array
+
+        // what the container hands out, const for one that has to see every write, see NameSet
+        using reference = decltype(std::declval<container&>().ref(0));
+        using const_reference = TComp const&;
+        using block = std::span<std::remove_reference_t<reference>>;
+        using const_block = std::span<TComp const>;
+        static constexpr size_t stride = sizeof(TComp);
+
+        ComponentManager(std::string_view name, std::pmr::memory_resource* memory = std::pmr::get_default_resource())
+            : ComponentManagerBase(name, memory), values(memory) { values.watcher = this; }
+        virtual ~ComponentManager() = default;
+
+        virtual auto has(Entity e) const -> bool override final { return values.contains(e); }
+        virtual void del(Entity e) override final { values.erase(e); }
+        virtual void delMany(std::span<Entity const> es) override final {
+            for (auto e : es)
+                values.erase(e);
+        }
+
+        auto get(Entity e) const -> TComp const& { return values.at(e); }
+        auto mut(Entity e) -> reference {
+            auto& res = values.at(e);
+            touch(e);
+            return res;
+        }
+        void set(Entity e, TComp&& v) {
+            admit(e);
+            auto n = values.size();
+            values.insert_or_assign(e, std::move(v));
+            touch(e);
+            if (values.size() == n)
+                record(ComponentEvent::Set, e); // an insertion is only an add
+        }
+
+        // sets many at once, the storage grows once up front rather than once per entity
+        void setRange(std::span<Entity const> es, TComp const& v = {}) {
+            std::ranges::for_each(es, [&](Entity e) { admit(e); });
+            values.reserve(es);
+            for (auto e : es) {
+                auto n = values.size();
+                values.insert_or_assign(e, v);
+                touch(e);
+                if (values.size() == n)
+                    record(ComponentEvent::Set, e);
+            }
+        }
+        void setRange(std::span<Entity const> es, std::span<TComp const> vs) {
+            if (vs.size() < es.size())
+                throw std::invalid_argument("ComponentManager::setRange fewer values than entities");
+            std::ranges::for_each(es, [&](Entity e) { admit(e); });
+            values.reserve(es);
+            for (size_t i = 0; i < es.size(); ++i) {
+                auto n = values.size();
+                values.insert_or_assign(es[i], vs[i]);
+                touch(es[i]);
+                if (values.size() == n)
+                    record(ComponentEvent::Set, es[i]);
+            }
+        }
+
+        void with(Entity e, std::invocable<reference> auto chain) {
+            if (auto v = values.find(e)) {
+                touch(e);
+                chain(*v); // reuse the found lookup
+            }
+        }
+
+        auto ref(size_t i) -> reference { return values.ref(i); }
+        auto cref(size_t i) const -> const_reference { return values.ref(i); }
+        auto blockAt(size_t i, size_t n) -> block { return { values.data.data() + i, n }; }
+        auto cblockAt(size_t i, size_t n) const -> const_block { return { values.data.data() + i, n }; }
+
+        virtual auto str(Entity e) const -> std::string override {
+            if (auto v = values.find(e))
+                if constexpr (Streamable<TComp>) {
+                    std::stringstream ss;
+                    ss << *v;
+                    return ss.str();
+                } else
+                    return "<UNSTREAMABLE>";
+            else
+                return "<NULL>";
+        }
+    };
+
+    // struct of arrays storage for components with a SoaLayout, references are proxies and reads are copies
+    template<SoaComponent TComp>
+    struct ComponentManager<TComp, SoaStorage> final : ComponentManagerBase {
+        SoaSet<Entity, TComp> values; // the actual arrays
+
+        using reference = typename SoaLayout<TComp>::Ref;
+        using const_reference = TComp;
+        using block = typename SoaSet<Entity, TComp>::Columns::block; // a span per field
+        using const_block = typename SoaSet<Entity, TComp>::Columns::const_block;
+        static constexpr size_t stride = SoaSet<Entity, TComp>::Columns::stride;
+
+        ComponentManager(std::string_view name, std::pmr::memory_resource* memory = std::pmr::get_default_resource())
+            : ComponentManagerBase(name, memory), values(memory) { values.watcher = this; }
+        virtual ~ComponentManager() = default;
+
+        virtual auto has(Entity e) const -> bool override final { return values.contains(e); }
+        virtual void del(Entity e) override final { values.erase(e); }
+        virtual void delMany(std::span<Entity const> es) override final {
+            for (auto e : es)
+                values.erase(e);
+        }
+
+        auto get(Entity e) const -> TComp { return values.at(e); }
+        auto mut(Entity e) -> reference {
+            auto res = values.at(e);
+            touch(e);
+            return res;
+        }
+        void set(Entity e, TComp&& v) {
+            admit(e);
+            auto n = values.size();
+            values.insert_or_assign(e, v);
+            touch(e);
+            if (values.size() == n)
+                record(ComponentEvent::Set, e); // an insertion is only an add
+        }
+
+        void setRange(std::span<Entity const> es, TComp const& v = {}) {
+            std::ranges::for_each(es, [&](Entity e) { admit(e); });
+            values.reserve(es);
+            for (auto e : es) {
+                auto n = values.size();
+                values.insert_or_assign(e, v);
+                touch(e);
+                if (values.size() == n)
+                    record(ComponentEvent::Set, e);
+            }
+        }
+        void setRange(std::span<Entity const> es, std::span<TComp const> vs) {
+            if (vs.size() < es.size())
+                throw std::invalid_argument("ComponentManager::setRange fewer values than entities");
+            std::ranges::for_each(es, [&](Entity e) { admit(e); });
+            values.reserve(es);
+            for (size_t i = 0; i < es.size(); ++i) {
+                auto n = values.size();
+                values.insert_or_assign(es[i], vs[i]);
+                touch(es[i]);
+                if (values.size() == n)
+                    record(ComponentEvent::Set, es[i]);
+            }
+        }
+
+        void with(Entity e, std::invocable<reference> auto chain) {
+            if (auto i = values.index(e); i != values.NoIndex) {
+                touch(e);
+                chain(values.ref(i)); // reuse the found lookup
+            }
+        }
+
+        auto ref(size_t i) -> reference { return values.ref(i); }
+        auto cref(size_t i) const -> const_reference { return values.ref(i); }
+        auto blockAt(size_t i, size_t n) -> block {
+            return std::apply([&](auto&... cs) { return block{ std::span(cs.data() + i, n)... }; }, values.columns);
+        }
+        auto cblockAt(size_t i, size_t n) const -> const_block {
+            return std::apply([&](auto const&... cs) { return const_block{ std::span(cs.data() + i, n)... }; }, values.columns);
+        }
+
+        virtual auto str(Entity e) const -> std::string override {
+            if (auto i = values.index(e); i != values.NoIndex)
+                if constexpr (Streamable<TComp>) {
+                    std::stringstream ss;
+                    ss << values.ref(i);
+                    return ss.str();
+                } else
+                    return "<UNSTREAMABLE>";
+            else
+                return "<NULL>";
+        }
+    };
+
+    // a run of `n` of a tag, there is nothing to point at
+    template<typename TComp>
+    struct TagBlock {
+        size_t n = 0;
+
+        auto size() const -> size_t { return n; }
+        auto operator[](size_t) const -> TComp { return {}; }
+    };
+
+    // a bit per entity index for empty components, values are made on demand
+    // the generation isn't kept, so a dead handle answers for whatever reused its index, ask the world first
+    template<typename TComp>
+    struct ComponentManager<TComp, TagStorage> final : ComponentManagerBase {
+        BitSet<Entity> values; // the actual bits
+
+        using reference = TComp;
+        using const_reference = TComp;
+        using block = TagBlock<TComp>;
+        using const_block = TagBlock<TComp>;
+        static constexpr size_t stride = sizeof(TComp);
+
+        ComponentManager(std::string_view name, std::pmr::memory_resource* memory = std::pmr::get_default_resource())
+            : ComponentManagerBase(name, memory), values(memory) { values.watcher = this; }
+        virtual ~ComponentManager() = default;
+
+        // the bits only keep the index, so every handle is checked against the generation the world issued
+        virtual auto has(Entity e) const -> bool override final { return live(e) && values.contains(e); }
+        virtual void del(Entity e) override final {
+            if (live(e))
+                values.erase(e);
+        }
+        virtual void delMany(std::span<Entity const> es) override final {
+            for (auto e : es)
+                del(e);
+        }
+
+        auto get(Entity e) const -> TComp {
+            if (!has(e))
+                throw std::out_of_range("ComponentManager::get tag not set");
+            return {};
+        }
+        auto mut(Entity e) -> reference {
+            auto res = get(e);
+            touch(e);
+            return res;
+        }
+        void set(Entity e, TComp&& = {}) {
+            admit(e);
+            if (!values.insert(e)) {
+                touch(e);
+                record(ComponentEvent::Set, e);
+            }
+        }
+
+        void setRange(std::span<Entity const> es, TComp const& = {}) {
+            std::ranges::for_each(es, [&](Entity e) { admit(e); });
+            values.reserve(es);
+            for (auto e : es)
+                set(e);
+        }
+        void setRange(std::span<Entity const> es, std::span<TComp const>) { setRange(es); }
+
+        void with(Entity e, std::invocable<reference> auto chain) {
+            if (has(e)) {
+                touch(e);
+                chain(TComp{});
+            }
+        }
+
+        auto ref(size_t) -> reference { return {}; }
+        auto cref(size_t) const -> const_reference { return {}; }
+        auto blockAt(size_t, size_t n) -> block { return { n }; }
+        auto cblockAt(size_t, size_t n) const -> const_block { return { n }; }
+
+        virtual auto str(Entity e) const -> std::string override {
+            if (has(e))
+                if constexpr (Streamable<TComp>) {
+                    std::stringstream ss;
+                    ss << TComp{};
+                    return ss.str();
+                } else
+                    return "<UNSTREAMABLE>";
+            else
+                return "<NULL>";
+        }
+    };
+
+    /* thread pool */
+
+    // a small work stealing pool, workers pop from the back of their own queue and steal from the front of the others
+    class ThreadPool {
+            struct Queue {
+                std::mutex lock;
+                std::deque<std::function<void()>> tasks;
+            };
+
+            std::vector<std::unique_ptr<Queue>> _queues; // one per worker, and a last one shared by outside threads
+            std::vector<std::jthread> _workers;
+            std::atomic<size_t> _next = 0;
+            std::atomic<size_t> _queued = 0;
+            std::mutex _sleep;
+            std::condition_variable_any _wake;
+
+            static inline thread_local ThreadPool* _owner = nullptr;
+            static inline thread_local size_t _self = 0;
+
+            void push(std::function<void()> task) {
+                auto i = (_owner == this || _workers.empty()) ? self() : _next++ % _workers.size();
+                ++_queued; // before the task can be seen, so taking it never brings the count below zero
+                {
+                    std::scoped_lock l(_queues[i]->lock);
+                    _queues[i]->tasks.push_back(std::move(task));
+                }
+                std::scoped_lock l(_sleep); // so a worker can't miss the wake between its check and its wait
+                _wake.notify_one();
+            }
+
+            auto tryRun(size_t self) -> bool {
+                std::function<void()> task;
+                for (size_t k = 0; k < _queues.size() && !task; ++k) {
+                    auto& q = *_queues[(self + k) % _queues.size()];
+                    std::scoped_lock l(q.lock);
+                    if (q.tasks.empty())
+                        continue;
+                    if (k == 0) {
+                        task = std::move(q.tasks.back());
+                        q.tasks.pop_back();
+                    } else {
+                        task = std::move(q.tasks.front());
+                        q.tasks.pop_front();
+                    }
+                }
+                if (!task)
+                    return false;
+                --_queued;
+                task();
+                return true;
+            }
+
+        public:
+            ThreadPool(size_t workers) {
+                for (size_t i = 0; i <= workers; ++i)
+                    _queues.push_back(std::make_unique<Queue>());
+                for (size_t i = 0; i < workers; ++i)
+                    _workers.emplace_back([this, i](std::stop_token stop) {
+                        _owner = this;
+                        _self = i;
+                        while (!stop.stop_requested()) {
+                            if (tryRun(i))
+                                continue;
+                            std::unique_lock l(_sleep);
+                            _wake.wait(l, stop, [&] { return _queued > 0; });
+                        }
+                    });
+            }
+            ~ThreadPool() {
+                for (auto& w : _workers)
+                    w.request_stop();
+                _wake.notify_all();
+                _workers.clear(); // join before the queues and wake are torn down
+            }
+
+            auto size() const -> size_t { return _workers.size() + 1; } // the waiting thread helps
+
+            // the calling thread's worker index, every thread outside of the pool shares the last one
+            auto self() const -> size_t { return (_owner == this) ? _self : _queues.size() - 1; }
 
-    /* component trinity */
+            // runs `f(i)` for every i in [0, n) and returns once all are done, rethrowing the first exception
+            // the calling thread runs tasks while it waits, so this may be nested inside another task
+            template<std::invocable<size_t> F>
+            void parallelFor(size_t n, F const& f) {
+                std::atomic<size_t> remaining = n;
+                std::exception_ptr error;
+                std::mutex errorLock;
+                for (size_t i = 0; i < n; ++i)
+                    push([&, i] {
+                        try { f(i); }
+                        catch (...) {
+                            std::scoped_lock l(errorLock);
+                            if (!error) error = std::current_exception();
+                        }
+                        remaining.fetch_sub(1, std::memory_order_release);
+                    });
+                while (remaining.load(std::memory_order_acquire) > 0)
+                    if (!tryRun(self()))
+                        std::this_thread::yield();
+                if (error)
+                    std::rethrow_exception(error);
+            }
+    };
 
-    struct ComponentManagerBase {
-        std::string name;
+    /* profiling */
 
-        ComponentManagerBase(std::string_view name)
-            : name(name) { }
-        virtual ~ComponentManagerBase() = default;
+    #ifndef DSECS_PROFILE
+    #define DSECS_PROFILE 0
+    #endif
+    // when off World::profile does nothing, and systems, queries and the world have no profiling members or checks
+    constexpr bool Profiling = DSECS_PROFILE;
 
-        virtual auto has(Entity e) const -> bool = 0;
-        virtual void del(Entity e) = 0;
+    // one run of one system, times in nanoseconds since its profiler was made
+    struct SystemSample {
+        uint32_t system = 0; // index into Profiler::names
+        uint32_t thread = 0; // the pool's index for the thread that ran it
+        uint64_t start = 0, duration = 0;
+        uint64_t visited = 0; // the entities its queries handed out through each, batches and par
+        uint64_t commands = 0; // what it recorded into its command buffer
+    };
 
-        virtual auto str(Entity e) const -> std::string = 0;
+    // keeps the latest samples, a writer claims its slot with one atomic add and never waits
+    // read it between updates, a slot that is written while it is read can come out torn
+    class SampleRing {
+            std::vector<SystemSample> _slots; // a power of two
+            std::atomic<uint64_t> _head = 0; // every sample ever pushed
+
+        public:
+            SampleRing(size_t capacity) : _slots(std::bit_ceil(std::max<size_t>(capacity, 1))) { }
+
+            auto capacity() const -> size_t { return _slots.size(); }
+            auto size() const -> size_t { return std::min<uint64_t>(_head.load(std::memory_order_relaxed), _slots.size()); }
+            auto dropped() const -> uint64_t { return _head.load(std::memory_order_relaxed) - size(); }
+            void clear() { _head.store(0, std::memory_order_relaxed); }
+
+            void push(SystemSample const& s) {
+                auto at = _head.fetch_add(1, std::memory_order_relaxed);
+                _slots[at & (_slots.size() - 1)] = s;
+            }
+
+            // oldest first
+            template<std::invocable<SystemSample const&> F>
+            void each(F&& f) const {
+                auto head = _head.load(std::memory_order_acquire);
+                for (auto at = head - size(); at < head; ++at)
+                    f(_slots[at & (_slots.size() - 1)]);
+            }
+    };
+
+    // the names of the systems it has seen, and their latest samples
+    class Profiler {
+            std::chrono::steady_clock::time_point _epoch = std::chrono::steady_clock::now();
+            std::vector<std::string> _names;
+
+        public:
+            static constexpr uint32_t NoTrace = std::numeric_limits<uint32_t>::max();
+
+            SampleRing samples;
+
+            Profiler(size_t capacity) : samples(capacity) { }
+
+            auto names() const -> std::vector<std::string> const& { return _names; }
+            auto clock() const -> uint64_t {
+                return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _epoch).count();
+            }
+
+            // gives a system its index into the names, the world enrolls every system before it runs any
+            void enroll(std::string_view name, uint32_t& trace) {
+                if (trace != NoTrace)
+                    return;
+                trace = uint32_t(_names.size());
+                _names.emplace_back(name);
+            }
+
+            // Chrome's trace_event JSON, for chrome://tracing or Perfetto, one complete event per sample
+            void writeTrace(std::ostream& os) const {
+                auto flags = os.flags();
+                auto precision = os.precision();
+                os << std::fixed << std::setprecision(3) << "{\"traceEvents\":[";
+                bool first = true;
+                samples.each([&](SystemSample const& s) {
+                    os << (std::exchange(first, false) ? "\n" : ",\n") << "{\"name\":\"";
+                    for (char c : _names[s.system]) {
+                        if (c == '"' || c == '\\')
+                            os << '\\';
+                        if (uint8_t(c) >= 0x20)
+                            os << c;
+                    }
+                    os << "\",\"cat\":\"system\",\"ph\":\"X\",\"pid\":0,\"tid\":" << s.thread
+                       << ",\"ts\":" << s.start / 1000.0 << ",\"dur\":" << s.duration / 1000.0
+                       << ",\"args\":{\"entities\":" << s.visited << ",\"commands\":" << s.commands << "}}";
+                });
+                os << "\n],\"displayTimeUnit\":\"ns\"}\n";
+                os.flags(flags);
+                os.precision(precision);
+            }
+
+            // "dsecsprf", the name count, each name's length and bytes, the sample count and the samples as they are
+            // in memory, every number in this machine's byte order
+            void writeBinary(std::ostream& os) const {
+                auto put = [&](auto const& v) { os.write(reinterpret_cast<char const*>(&v), sizeof(v)); };
+                os.write("dsecsprf", 8);
+                put(uint32_t(_names.size()));
+                for (auto& n : _names) {
+                    put(uint32_t(n.size()));
+                    os.write(n.data(), std::streamsize(n.size()));
+                }
+                put(uint64_t(samples.size()));
+                samples.each(put);
+            }
     };
 
+    /* queries */
+
+    // a query term that only matches entities whose component was possibly written at or after the query's tick
+    // e.g. `Changed<Transform const>`, by default that is since the running system last ran
     template<typename TComp>
-    struct ComponentManager final : ComponentManagerBase {
-        std::unordered_map<Entity, TComp> values; // the actual array
+    struct Changed { };
 
-        ComponentManager(std::string_view name)
-            : ComponentManagerBase(name), values() { }
-        virtual ~ComponentManager() = default;
+    template<typename TTerm>
+    struct QueryTerm {
+        using type = TTerm; // the component, const qualified when only read
+        static constexpr bool changed = false;
+    };
+    template<typename TComp>
+    struct QueryTerm<Changed<TComp>> {
+        using type = TComp;
+        static constexpr bool changed = true;
+    };
 
-        virtual auto has(Entity e) const -> bool override final { return values.contains(e); }
-        virtual void del(Entity e) override final { values.erase(e); }
+    template<typename TTerm>
+    using QueryComponent = std::remove_const_t<typename QueryTerm<TTerm>::type>;
 
-        auto get(Entity e) const -> TComp const& { return values.at(e); }
-        auto mut(Entity e) -> TComp& { return values.at(e); }
-        void set(Entity e, TComp&& v) { values.insert_or_assign(e, v); }
+    // what a query yields for a component, const qualified components are read through const_reference
+    template<typename TTerm>
+    using QueryRef = std::conditional_t<std::is_const_v<typename QueryTerm<TTerm>::type>,
+        typename ComponentManager<QueryComponent<TTerm>>::const_reference,
+        typename ComponentManager<QueryComponent<TTerm>>::reference>;
+
+    // what a batch yields for a component, a span of it, or a span per field for struct of arrays storage
+    template<typename TTerm>
+    using QueryBlock = std::conditional_t<std::is_const_v<typename QueryTerm<TTerm>::type>,
+        typename ComponentManager<QueryComponent<TTerm>>::const_block,
+        typename ComponentManager<QueryComponent<TTerm>>::block>;
+
+    struct SystemBase;
+
+    // the system the calling thread runs for, what the world's deltaTime, commands and queries answer with
+    // set by the world around each run, and by a parallel query around each of its chunks, which may run on any thread
+    class RunningSystem {
+            struct State {
+                SystemBase* system;
+                bool chunk; // one of several threads running for the system at once
+            };
+            static inline thread_local State _current = {};
+            State _outer; // restored after, a thread waiting inside a system may run another while it helps
+
+        public:
+            RunningSystem(SystemBase* system, bool chunk = false) : _outer(std::exchange(_current, State{ system, chunk })) { }
+            ~RunningSystem() { _current = _outer; }
+            RunningSystem(RunningSystem const&) = delete;
+            auto operator=(RunningSystem const&) -> RunningSystem& = delete;
 
-        void with(Entity e, std::invocable<TComp&> auto chain) {
-            if (auto it = values.find(e); it != values.end())
-                chain(it->second); // reuse the found iterator/lookup
+            static auto system() -> SystemBase* { return _current.system; }
+            static auto chunk() -> bool { return _current.chunk; }
+    };
+
+    // a join over several component managers, `TComps` may be const qualified for read only access
+    // iteration walks the smallest manager and probes each of the others exactly once per entity
+    // tags have no packed keys to walk, so they only ever filter, see World::eachTagged for tags alone
+    // several tags are intersected 64 entities at a time when the query is made, and filter as a single bit
+    // mutable access is a possible write, so it stamps the entity's change tick as it is handed out
+    template<typename... TComps>
+    struct Query {
+        static_assert(!(TagComponent<QueryComponent<TComps>> && ...), "Query needs a component that isn't a tag to walk");
+
+        static constexpr size_t N = sizeof...(TComps);
+        static constexpr size_t Tags = (size_t(TagComponent<QueryComponent<TComps>>) + ...);
+        static constexpr size_t CacheLine = 64;
+        static constexpr size_t DefaultChunk = 1024;
+        static constexpr size_t RunBlock = 64;
+        using TIndex = SparseIndex<Entity>::TDenseIndex;
+        static constexpr TIndex NoIndex = SparseIndex<Entity>::NoIndex;
+        using value_type = std::tuple<Entity, QueryRef<TComps>...>;
+
+        template<size_t I>
+        using Term = QueryTerm<std::tuple_element_t<I, std::tuple<TComps...>>>;
+        template<size_t I>
+        static constexpr bool IsTag = TagComponent<std::remove_const_t<typename Term<I>::type>>;
+        template<size_t I>
+        static constexpr bool IsConst = std::is_const_v<typename Term<I>::type>;
+
+        std::tuple<ComponentManager<QueryComponent<TComps>>*...> managers;
+        std::array<std::pmr::vector<Entity> const*, N> keys;
+        size_t driver = 0; // the manager with the fewest entities
+        ThreadPool* pool = nullptr; // for par(), which runs in sequence without one
+        Tick since = 0; // what Changed terms compare against
+        Tick stamp = 0; // what mutable access is stamped with, the clock doesn't move while a system runs
+    #if DSECS_PROFILE
+        std::atomic<uint64_t>* visited = nullptr; // the running system's count, while profiling
+    #endif
+        SystemBase* owner = RunningSystem::system(); // the system that made this, its parallel chunks run for it
+        BitSet<Entity> tagged; // the entities with every tag term, when there are several
+
+        Query(ThreadPool* pool, Tick since, ComponentManager<QueryComponent<TComps>>*... ms)
+            : managers(ms...), keys{ keysOf(ms)... }, pool(pool), since(since), stamp(std::get<0>(managers)->now()) {
+            std::array<size_t, N> sizes = { (keysOf(ms) ? ms->values.size() : std::numeric_limits<size_t>::max())... };
+            ((QueryTerm<TComps>::changed ? ms->track() : void()), ...);
+            driver = std::ranges::min_element(sizes) - sizes.begin();
+            if constexpr (Tags > 1) {
+                std::array<BitSet<Entity> const*, Tags> sets;
+                size_t t = 0;
+                ([&] { if constexpr (TagComponent<QueryComponent<TComps>>) sets[t++] = &ms->values; }(), ...);
+                tagged = BitSet<Entity>::intersection(sets);
+            }
         }
 
-        virtual auto str(Entity e) const -> std::string override {
-            if (auto it = values.find(e); it != values.end())
-                if constexpr (Streamable<TComp>) {
-                    std::stringstream ss;
-                    ss << it->second;
-                    return ss.str();
-                } else
-                    return "<UNSTREAMABLE>";
+        struct Iterator {
+            using difference_type = std::ptrdiff_t;
+            using value_type = Query::value_type;
+
+            Query const* q = nullptr;
+            size_t i = 0, last = 0; // the range of the driving manager's dense array to walk
+            std::array<TIndex, N> idx = {}; // the probed dense index into each manager
+
+            Iterator() = default;
+            Iterator(Query const* q, size_t i, size_t last) : q(q), i(i), last(last) { seek(); }
+
+            auto operator*() const -> value_type {
+                return [&]<size_t... Is>(std::index_sequence<Is...>) {
+                    auto e = (*q->keys[q->driver])[i];
+                    return value_type{ e, q->template fetch<Is>(idx[Is], e)... };
+                }(std::index_sequence_for<TComps...>{});
+            }
+            auto operator++() -> Iterator& { ++i; seek(); return *this; }
+            auto operator++(int) -> Iterator { auto res = *this; ++*this; return res; }
+            auto operator==(Iterator const& o) const -> bool { return i == o.i; }
+
+        private:
+            void seek() {
+                auto& driving = *q->keys[q->driver];
+                for (; i < last; ++i)
+                    if (probe(driving[i]))
+                        return;
+            }
+            auto probe(Entity e) -> bool {
+                return [&]<size_t... Is>(std::index_sequence<Is...>) {
+                    // short circuits on the first manager missing the entity, ticks and tags go first as they are cheapest
+                    return ((!Term<Is>::changed || std::get<Is>(q->managers)->changedSince(e, q->since)) && ...)
+                        && q->hasTags(e)
+                        && ((IsTag<Is> || (idx[Is] = (Is == q->driver) ? TIndex(i) : std::get<Is>(q->managers)->values.index(e), idx[Is] != NoIndex)) && ...);
+                }(std::index_sequence_for<TComps...>{});
+            }
+        };
+
+        auto begin() const { return Iterator(this, 0, keys[driver]->size()); }
+        auto end() const { return Iterator(this, keys[driver]->size(), keys[driver]->size()); }
+
+        template<size_t I>
+        auto fetch(TIndex i, Entity e) const -> QueryRef<std::tuple_element_t<I, std::tuple<TComps...>>> {
+            auto m = std::get<I>(managers);
+            if constexpr (IsConst<I>)
+                return m->cref(i);
+            else {
+                m->touch(e, stamp);
+                return m->ref(i);
+            }
+        }
+
+        template<size_t I>
+        auto fetchBlock(TIndex i, std::span<Entity const> es) const -> QueryBlock<std::tuple_element_t<I, std::tuple<TComps...>>> {
+            auto m = std::get<I>(managers);
+            if constexpr (IsConst<I>)
+                return m->cblockAt(i, es.size());
+            else {
+                m->touch(es, stamp);
+                return m->blockAt(i, es.size());
+            }
+        }
+
+        template<std::invocable<Entity, QueryRef<TComps>...> F>
+        void each(F const& f) const {
+            size_t n = 0;
+            for (auto row : *this) {
+                std::apply(f, row);
+                ++n;
+            }
+            count(n);
+        }
+
+        // hands `f(entities, blocks...)` each run of matches that sit next to each other in every manager, in place
+        // so kernels can loop over plain arrays, runs are only long where the managers were filled in the same order
+        template<std::invocable<std::span<Entity const>, QueryBlock<TComps>...> F>
+        void batches(F const& f) const {
+            auto& driving = *keys[driver];
+            for (Iterator it(this, 0, driving.size()), end = this->end(); it != end;) {
+                auto es = std::span(driving.data() + it.i, runLength(it.i, it.idx));
+                [&]<size_t... Is>(std::index_sequence<Is...>) {
+                    f(es, fetchBlock<Is>(it.idx[Is], es)...);
+                }(std::index_sequence_for<TComps...>{});
+                count(es.size());
+                it = Iterator(this, it.i + es.size(), driving.size());
+            }
+        }
+
+        // splits the driving manager's dense array into chunks of at least `minChunk` and runs them on the pool
+        // chunks are a whole number of cache lines of the driving component, the storage isn't aligned to a line so
+        // neighbouring chunks may still share the one line at their boundary, but no more
+        // each chunk runs for the system that made the query, so its commands and queries inside behave as outside
+        template<std::invocable<Entity, QueryRef<TComps>...> F>
+        void par(F const& f, size_t minChunk = DefaultChunk) const {
+            static constexpr std::array<size_t, N> strides = { ComponentManager<QueryComponent<TComps>>::stride... };
+            auto n = keys[driver]->size();
+            auto line = std::lcm(CacheLine, strides[driver]) / strides[driver];
+            auto threads = pool ? pool->size() : 1;
+            auto chunk = std::max(minChunk, n / (threads * 4)); // a few chunks per thread, to leave some to steal
+            chunk = (chunk + line - 1) / line * line;
+            auto chunks = (n + chunk - 1) / chunk;
+            if (!pool || chunks <= 1)
+                return each(f);
+
+            pool->parallelFor(chunks, [&](size_t c) {
+                RunningSystem running(owner, true);
+                auto hi = std::min(n, (c + 1) * chunk);
+                size_t visits = 0;
+                for (Iterator it(this, c * chunk, hi), end(this, hi, hi); it != end; ++it, ++visits)
+                    std::apply(f, *it);
+                count(visits);
+            });
+        }
+
+    private:
+        auto hasTags(Entity e) const -> bool {
+            if constexpr (Tags > 1)
+                return tagged.contains(e);
             else
-                return "<NULL>";
+                return [&]<size_t... Is>(std::index_sequence<Is...>) {
+                    return ((!IsTag<Is> || std::get<Is>(managers)->values.contains(e)) && ...);
+                }(std::index_sequence_for<TComps...>{});
+        }
+
+        void count([[maybe_unused]] size_t n) const {
+        #if DSECS_PROFILE
+            if (visited)
+                visited->fetch_add(n, std::memory_order_relaxed);
+        #endif
+        }
+
+        template<typename TManager>
+        static auto keysOf(TManager* m) -> std::pmr::vector<Entity> const* {
+            if constexpr (requires { m->values.dense; })
+                return &m->values.dense;
+            else
+                return nullptr;
+        }
+
+        // a run lasts as long as every manager's packed keys match the driving ones, no probing needed
+        auto runLength(size_t i, std::array<TIndex, N> const& idx) const -> size_t {
+            auto first = keys[driver]->begin() + i;
+            size_t n = keys[driver]->size() - i;
+            [&]<size_t... Is>(std::index_sequence<Is...>) {
+                ((n = (Is == driver) ? n : runLength<Is>(first, n, idx[Is])), ...);
+                ((n = Term<Is>::changed ? changedLength<Is>(first, n) : n), ...);
+            }(std::index_sequence_for<TComps...>{});
+            return n;
+        }
+        template<size_t I>
+        auto changedLength(std::pmr::vector<Entity>::const_iterator first, size_t n) const -> size_t {
+            auto m = std::get<I>(managers);
+            return std::find_if_not(first, first + n, [&](Entity e) { return m->changedSince(e, since); }) - first;
+        }
+        template<size_t I>
+        auto runLength(std::pmr::vector<Entity>::const_iterator first, size_t n, TIndex at) const -> size_t {
+            if constexpr (IsTag<I>) {
+                // a tag, the run lasts while the driving keys have its bit, or every tag's bit when there are several
+                return std::find_if_not(first, first + n, [&](Entity e) { return hasTags(e); }) - first;
+            } else {
+                auto other = keys[I]->begin() + at;
+                auto len = std::min(n, size_t(keys[I]->end() - other));
+                // whole blocks compare as memory, only the block holding the mismatch is walked key by key
+                size_t m = 0;
+                while (m + RunBlock <= len && std::equal(first + m, first + m + RunBlock, other + m))
+                    m += RunBlock;
+                auto stop = first + std::min(len, m + RunBlock);
+                return std::mismatch(first + m, stop, other + m).first - first;
+            }
+        }
+    };
+
+    /* deferred commands */
+
+    struct CommandQueueBase {
+        virtual ~CommandQueueBase() = default;
+
+        virtual void apply(class World& w, struct CommandBuffer const& b) = 0;
+        virtual auto size() const -> size_t = 0;
+    };
+
+    // the pending changes to a single component type, applied to its manager in one pass
+    template<typename TComp>
+    struct CommandQueue final : CommandQueueBase {
+        std::vector<std::pair<Entity, std::optional<TComp>>> ops; // in recorded order, nullopt deletes
+
+        virtual void apply(class World& w, struct CommandBuffer const& b) override;
+        virtual auto size() const -> size_t override { return ops.size(); }
+    };
+
+    // structural changes recorded while iterating, and applied by the world at its next sync point
+    struct CommandBuffer {
+        // spawned entities are placeholders until applied, their generation has this bit set, which no live entity's
+        // reaches, and the rest of it is the id of the buffer, renewed on every apply, so a placeholder is only ever
+        // resolved by the buffer and the batch of commands it came from
+        static constexpr EntityGeneration Pending = EntityGeneration(1) << 31;
+
+        static constexpr auto isPending(Entity e) -> bool { return entityGeneration(e) & Pending; }
+
+        EntityGeneration id = nextId(); // of the commands being recorded
+        EntityGeneration appliedId = 0; // of the last commands applied, what `spawned` resolves
+        EntityIndex spawns = 0;
+        std::vector<Entity> spawned; // placeholder index -> real entity, filled in when applied and kept until the next
+        std::vector<Entity> kills;
+        std::vector<std::unique_ptr<CommandQueueBase>> queues; // by component id like the world
+
+        auto spawn() -> Entity { return makeEntity(spawns++, Pending | id); }
+        void kill(Entity e) { kills.push_back(recordable(e)); }
+
+        template<typename TComp>
+        void set(Entity e, TComp v) { queue<TComp>().ops.emplace_back(recordable(e), std::move(v)); }
+        template<typename TComp>
+        void del(Entity e) { queue<TComp>().ops.emplace_back(recordable(e), std::nullopt); }
+
+        // whether `e` is a placeholder this buffer handed out, applied or not
+        auto owns(Entity e) const -> bool {
+            return isPending(e) && (entityGeneration(e) == (Pending | id) || entityGeneration(e) == (Pending | appliedId));
+        }
+
+        // the real entity for a placeholder once its commands are applied, other entities are returned as they are
+        auto resolve(Entity e) const -> Entity {
+            if (!isPending(e))
+                return e;
+            if (entityGeneration(e) != (Pending | appliedId))
+                throw std::invalid_argument(entityGeneration(e) == (Pending | id)
+                    ? "CommandBuffer::resolve placeholder is not applied yet" : "CommandBuffer::resolve placeholder of another buffer");
+            return spawned.at(entityIndex(e));
+        }
+
+        auto empty() const -> bool { return spawns == 0 && kills.empty() && queues.empty(); }
+        // the commands recorded, every spawn, kill, set and del
+        auto size() const -> size_t {
+            size_t n = spawns + kills.size();
+            for (auto& q : queues)
+                n += q ? q->size() : 0;
+            return n;
+        }
+
+        // the world calls these around applying, the spawned entities stay resolvable until the next apply
+        void applying() {
+            appliedId = std::exchange(id, nextId());
+            spawned.clear();
+        }
+        void clear() { spawns = 0; kills.clear(); queues.clear(); }
+
+    private:
+        static auto nextId() -> EntityGeneration {
+            static std::atomic<EntityGeneration> ids = 0;
+            return (ids.fetch_add(1, std::memory_order_relaxed) + 1) & ~Pending;
+        }
+
+        auto recordable(Entity e) const -> Entity {
+            if (isPending(e) && entityGeneration(e) != (Pending | id))
+                throw std::invalid_argument("CommandBuffer placeholder of another buffer, or of commands already applied");
+            return e;
+        }
+
+    private:
+        template<typename TComp>
+        auto queue() -> CommandQueue<TComp>& {
+            auto id = componentId<TComp>();
+            if (id >= queues.size())
+                queues.resize(id + 1);
+            auto& res = queues[id];
+            if (!res)
+                res = std::make_unique<CommandQueue<TComp>>();
+            // this static cast is safe because we index by component id
+            return static_cast<CommandQueue<TComp>&>(*res);
         }
     };
 
     /* system trinity */
 
+    // systems run phase by phase, ordering constraints only order systems within a phase
+    enum class Phase : uint8_t { PreUpdate, Update, PostUpdate };
+
+    using Seconds = double;
+
     struct SystemBase {
         std::string name;
         bool enable = true;
+        CommandBuffer commands; // applied by the world after the update that recorded them
+        std::vector<CommandBuffer> chunkCommands; // what the chunks of its parallel queries record, one per pool thread
+
+        // the names of the systems this must run before and after, names no system has are ignored
+        Phase phase = Phase::Update;
+        std::vector<std::string> runsBefore, runsAfter;
+        bool reordered = true; // set when the constraints change, the world rebuilds its schedule and clears it
+
+        // a system with an interval runs once it has passed, otherwise every update
+        // a fixed step runs once per whole interval passed, catching up to `maxSteps` times in one update and dropping
+        // the rest, each run covering exactly one interval, while a loose one runs at most once covering all the time
+        // since it last ran, and is staggered by the world against other loose systems
+        Seconds interval = 0;
+        bool fixed = false;
+        size_t maxSteps = 4;
+        Seconds accumulated = 0, elapsed = 0;
+        Seconds delta = 0; // the time the current run covers, see World::deltaTime
+        bool staggered = false;
+
+        // the components this system touches, systems that never declared them are exclusive
+        std::vector<ComponentId> reads, writes;
+        bool exclusive = true;
+        Tick lastRun = 0; // the clock just after this last ran, what its Changed terms compare against
+
+    #if DSECS_PROFILE
+        // only kept while the world is profiling
+        uint32_t trace = Profiler::NoTrace; // its index into the profiler's names
+        std::atomic<uint64_t> visited = 0; // by its queries, during the current run
+    #endif
+
+        auto conflicts(SystemBase const& o) const -> bool {
+            if (exclusive || o.exclusive)
+                return true;
+            auto overlaps = [](auto const& a, auto const& b) { return std::ranges::find_first_of(a, b) != a.end(); };
+            return overlaps(writes, o.writes) || overlaps(writes, o.reads) || overlaps(reads, o.writes);
+        }
 
         SystemBase(std::string_view name)
             : name(name) { }
         virtual ~SystemBase() = default;
 
+        auto before(std::string_view o) -> SystemBase& { runsBefore.emplace_back(o); reordered = true; return *this; }
+        auto after(std::string_view o) -> SystemBase& { runsAfter.emplace_back(o); reordered = true; return *this; }
+        auto inPhase(Phase p) -> SystemBase& { phase = p; reordered = true; return *this; }
+        auto every(Seconds i) -> SystemBase& { interval = i; fixed = false; staggered = false; reordered = true; return *this; }
+        auto rate(double hz) -> SystemBase& { return every(1.0 / hz); }
+        auto fixedStep(Seconds i) -> SystemBase& { interval = i; fixed = true; accumulated = 0; elapsed = 0; return *this; }
+
+        // how many times to run for an update of `dt`, setting the delta each of those runs covers
+        auto due(Seconds dt) -> size_t {
+            if (interval <= 0) {
+                delta = dt;
+                return 1;
+            }
+            accumulated += dt;
+            if (!fixed)
+                elapsed += dt; // only a loose run covers it all, and takes it back to 0
+            if (accumulated < interval)
+                return 0;
+            if (fixed) {
+                auto steps = std::min(size_t(accumulated / interval), maxSteps);
+                accumulated = (steps < maxSteps) ? accumulated - steps * interval : std::fmod(accumulated, interval);
+                delta = interval;
+                return steps;
+            }
+            // keeps its phase, rather than drifting by however much the update overshot
+            accumulated = std::fmod(accumulated, interval);
+            delta = std::exchange(elapsed, 0);
+            return 1;
+        }
+
         virtual void update(class World* w) = 0;
     };
 
@@ -92,86 +1876,683 @@ namespace dsecs {
         virtual void update(class World* w) override { execution(w); } // the actual dispatch
     };
 
+    // the components a system touches, const qualified components are only read, Changed terms count as their component
+    template<typename... TComps>
+    struct Access {
+        static void declare(SystemBase& sys) {
+            sys.exclusive = false;
+            ((std::is_const_v<typename QueryTerm<TComps>::type> ? sys.reads : sys.writes).push_back(componentId<QueryComponent<TComps>>()), ...);
+        }
+    };
+
     /* name ergonomics */
 
+    struct NameStorage;
+
+    // views the world's interned copy, every Name set through its manager, directly, by a command or by
+    // World::requireEntity, is copied in as it is stored, so only a command's pending Name views the caller's text
     struct Name {
-        std::string name;
+        using storage = NameStorage;
+        std::string_view name;
     };
 
     auto& operator<<(std::ostream& os, Name n) {
         return os << n.name;
     }
 
+    // name -> entity, over text interned into pooled blocks that never move, so keys and Name values can both view it
+    // watches the Name manager, an entity's text and entry go as soon as its Name does, killed or not
+    class NameIndex final : public SparseWatcher<Entity> {
+            std::pmr::unsynchronized_pool_resource _text; // one block per name, recycled by size once the entity goes, and the nodes
+            std::pmr::unordered_multimap<std::string_view, Entity> _entities; // a name can be given to several entities
+            std::pmr::vector<std::string_view> _names; // entity index -> its interned name, null data when unnamed
+
+        public:
+            NameIndex(std::pmr::memory_resource* memory = std::pmr::get_default_resource())
+                : _text(memory), _entities(&_text), _names(memory) { }
+
+            auto size() const -> size_t { return _entities.size(); } // named entities, not distinct names
+
+            // a string_view key, so looking up never allocates
+            auto find(std::string_view name) const -> Entity {
+                auto it = _entities.find(name);
+                return it != _entities.end() ? it->second : NoEntity;
+            }
+
+            // interns the entity's name in place of any it had, returns the stable copy for its Name to view
+            // a name given to several entities finds one of them, for as long as any of them keeps it
+            auto add(Entity e, std::string_view name) -> std::string_view {
+                auto text = static_cast<char*>(_text.allocate(std::max<size_t>(name.size(), 1), 1));
+                std::ranges::copy(name, text);
+                auto interned = std::string_view(text, name.size());
+                erased(e); // only after the copy, the new name may view the old one
+                _entities.emplace(interned, e);
+                if (entityIndex(e) >= _names.size())
+                    _names.resize(std::max<size_t>(entityIndex(e) + 1, _names.size() * 2));
+                _names[entityIndex(e)] = interned;
+                return interned;
+            }
+
+            void inserted(Entity) override { }
+            void erased(Entity e) override {
+                if (entityIndex(e) >= _names.size() || !_names[entityIndex(e)].data())
+                    return;
+                auto name = std::exchange(_names[entityIndex(e)], {});
+                auto [first, last] = _entities.equal_range(name);
+                if (auto it = std::find_if(first, last, [e](auto& kv) { return kv.second == e; }); it != last)
+                    _entities.erase(it);
+                _text.deallocate(const_cast<char*>(name.data()), std::max<size_t>(name.size(), 1), 1);
+            }
+    };
+
+    // the Name manager's values, which intern every name written before keeping it
+    // insert_or_assign is the only way in, everything else hands out const, so no write can skip the interner
+    struct NameSet : SparseSet<Entity, Name> {
+        NameIndex* interner = nullptr; // attached by the world before any name can be written
+
+        using SparseSet::SparseSet;
+
+        auto insert_or_assign(Entity e, Name v) -> Name const& {
+            if (interner)
+                v.name = interner->add(e, v.name);
+            return SparseSet::insert_or_assign(e, v);
+        }
+
+        auto operator[](Entity) -> Name& = delete;
+        template<typename... TArgs> auto emplace(Entity, TArgs&&...) -> Name& = delete;
+
+        auto begin() const { return SparseSet::begin(); }
+        auto end() const { return SparseSet::end(); }
+        auto ref(size_t i) const -> Name const& { return SparseSet::ref(i); }
+        auto find(Entity e) const -> Name const* { return SparseSet::find(e); }
+        auto at(Entity e) const -> Name const& { return SparseSet::at(e); }
+    };
+
+    struct NameStorage {
+        template<typename TComp> using container = NameSet;
+    };
+
     /* final world type */
 
     class World {
-            Entity _nextEntity = 1;
-            std::unordered_map<size_t, std::shared_ptr<ComponentManagerBase>> _components; // the dynamic structure
-            std::vector<std::shared_ptr<SystemBase>> _systems; // the dynamic update list
-            std::unordered_map<std::string_view, Entity> _entityNames;
+            struct EntitySlot {
+                EntityGeneration generation = 0;
+                uint32_t alive = std::numeric_limits<uint32_t>::max(); // position in _alive, max when dead
+            };
+
+            std::pmr::memory_resource* _memory; // the entities and components, but not systems or commands, live here
+            std::pmr::vector<EntitySlot> _slots; // index -> slot, the first is reserved for NoEntity
+            std::pmr::vector<Entity> _alive; // the packed live entities
+            std::pmr::vector<EntityIndex> _free; // dead indices ready for reuse
+            std::pmr::vector<std::shared_ptr<ComponentManagerBase>> _components; // the dynamic structure, by component id
+            std::shared_ptr<Signatures> _signatures; // kept up to date by the managers
+            std::shared_ptr<Clock> _clock; // advanced around each system run, stamped into the managers' ticks
+            std::vector<ComponentManagerBase*> _observed; // the managers with observers, notified at system boundaries
+            std::vector<std::shared_ptr<SystemBase>> _systems; // the dynamic update list, in the order they were made
+            std::unordered_map<std::string, std::shared_ptr<SystemBase>> _systemNames; // the first system made with each name
+
+            // the order systems run in, built once and only rebuilt when systems are made, removed, reordered or toggled
+            struct Schedule {
+                std::vector<size_t> order; // indices of every system, phase by phase, meeting their constraints
+                std::vector<std::vector<size_t>> preds; // by index, the systems that must run first in the same phase
+                std::vector<std::vector<SystemBase*>> batches; // the enabled systems, no two in a batch ordered or conflicting
+                std::vector<bool> enabled; // by index, what the batches were grouped for
+                bool stale = true;
+            } _schedule;
+            std::shared_ptr<NameIndex> _entityNames; // shared with the Name manager it watches
+            std::vector<CommandBuffer> _commands = std::vector<CommandBuffer>(1); // outside of any system, one per pool thread
+            std::unique_ptr<ThreadPool> _pool; // when set, non-conflicting systems run in parallel
+        #if DSECS_PROFILE
+            std::unique_ptr<Profiler> _profiler; // when set, every system run is sampled
+        #endif
+            std::pmr::vector<std::pmr::vector<Entity>> _victimsBy; // scratch for killBatch, by component id
+
+
+            // swap-and-pop out of the alive list, then bump the generation so old handles go stale
+            void release(Entity e) {
+                auto& slot = _slots[entityIndex(e)];
+                _slots[entityIndex(_alive.back())].alive = slot.alive;
+                _alive[slot.alive] = _alive.back();
+                _alive.pop_back();
+                slot = { (slot.generation + 1) % CommandBuffer::Pending }; // wraps before reaching a placeholder's
+                _signatures->issue(makeEntity(entityIndex(e), slot.generation)); // the old handle is stale from here
+                _free.push_back(entityIndex(e));
+            }
+
+            // one pass per component manager, rather than one pass over the managers per entity
+            // the victims are bucketed by their signatures, so a manager only sees the entities that have it
+            // they are released only after, so the managers still take their handles as live, a repeat erases nothing
+            void killBatch(std::span<Entity const> es) {
+                _victimsBy.resize(_components.size());
+                for (auto e : es) {
+                    if (!isAlive(e))
+                        continue;
+                    auto sig = _signatures->of(entityIndex(e));
+                    for (ComponentId c = 0; c < _components.size() && sig.any(); ++c)
+                        if (sig[c]) {
+                            _victimsBy[c].push_back(e);
+                            sig.reset(c);
+                        }
+                }
+                for (ComponentId c = 0; c < _components.size(); ++c)
+                    if (!_victimsBy[c].empty()) {
+                        _components[c]->delMany(_victimsBy[c]);
+                        _victimsBy[c].clear();
+                    }
+                for (auto e : es)
+                    if (isAlive(e))
+                        release(e);
+            }
+
+            // Kahn's algorithm, always taking the earliest made of the ready systems so unconstrained ones keep their order
+            void reorder() {
+                auto n = _systems.size();
+                std::unordered_map<std::string_view, std::vector<size_t>> byName;
+                for (size_t i = 0; i < n; ++i)
+                    byName[_systems[i]->name].push_back(i);
+
+                std::vector<std::vector<size_t>> next(n), preds(n);
+                auto edge = [&](size_t first, size_t then) {
+                    auto pf = _systems[first]->phase, pt = _systems[then]->phase;
+                    if (pf > pt)
+                        throw std::invalid_argument("World::systemOrder " + _systems[first]->name + " can't run before "
+                            + _systems[then]->name + " in an earlier phase");
+                    if (pf == pt) { // otherwise the phases already order them
+                        next[first].push_back(then);
+                        preds[then].push_back(first);
+                    }
+                };
+                for (size_t i = 0; i < n; ++i) {
+                    for (auto& o : _systems[i]->runsBefore)
+                        if (auto it = byName.find(o); it != byName.end())
+                            for (auto j : it->second)
+                                edge(i, j);
+                    for (auto& o : _systems[i]->runsAfter)
+                        if (auto it = byName.find(o); it != byName.end())
+                            for (auto j : it->second)
+                                edge(j, i);
+                }
+
+                auto later = [&](size_t a, size_t b) { return std::pair(_systems[a]->phase, a) > std::pair(_systems[b]->phase, b); };
+                std::priority_queue<size_t, std::vector<size_t>, decltype(later)> ready(later);
+                std::vector<size_t> pending(n), order;
+                for (size_t i = 0; i < n; ++i)
+                    if ((pending[i] = preds[i].size()) == 0)
+                        ready.push(i);
+                while (!ready.empty()) {
+                    auto i = ready.top();
+                    ready.pop();
+                    order.push_back(i);
+                    for (auto j : next[i])
+                        if (--pending[j] == 0)
+                            ready.push(j);
+                }
+                if (order.size() != n)
+                    throw std::invalid_argument("World::systemOrder the ordering constraints form a cycle");
+
+                _schedule.order = std::move(order);
+                _schedule.preds = std::move(preds);
+                for (auto& sys : _systems)
+                    sys->reordered = false;
+                stagger();
+                regroup();
+                _schedule.stale = false;
+            }
+
+            // loose systems with an interval start part way into it, spread along the golden ratio so that systems at the
+            // same rate rarely land on the same update
+            void stagger() {
+                constexpr double Golden = 0.6180339887498949;
+                size_t k = 0;
+                for (auto& sys : _systems) {
+                    if (sys->interval <= 0 || sys->fixed)
+                        continue;
+                    if (!sys->staggered) {
+                        sys->accumulated = sys->interval * std::fmod(k * Golden, 1.0);
+                        sys->staggered = true;
+                    }
+                    ++k;
+                }
+            }
+
+            // a system lands in the batch after the last one holding a system it conflicts with or must follow
+            // disabled systems hold no batch, but still pass their constraints on to the systems after them
+            void regroup() {
+                auto& batches = _schedule.batches;
+                batches.clear();
+                std::vector<size_t> least(_systems.size()); // by index, the first batch the systems after it may use
+                size_t phaseStart = 0;
+                for (size_t k = 0; k < _schedule.order.size(); ++k) {
+                    auto i = _schedule.order[k];
+                    auto& sys = *_systems[i];
+                    if (k > 0 && sys.phase != _systems[_schedule.order[k - 1]]->phase)
+                        phaseStart = batches.size();
+                    auto at = phaseStart;
+                    for (auto p : _schedule.preds[i])
+                        at = std::max(at, least[p]);
+                    if (sys.enable) {
+                        for (size_t b = batches.size(); b > at; --b)
+                            if (std::ranges::any_of(batches[b - 1], [&](auto o) { return sys.conflicts(*o); })) {
+                                at = b;
+                                break;
+                            }
+                        if (at == batches.size())
+                            batches.emplace_back();
+                        batches[at].push_back(&sys);
+                        ++at;
+                    }
+                    least[i] = at;
+                }
+                _schedule.enabled.assign(_systems.size(), false);
+                for (size_t i = 0; i < _systems.size(); ++i)
+                    _schedule.enabled[i] = _systems[i]->enable;
+            }
+
+            auto schedule() -> Schedule const& {
+                if (_schedule.stale || std::ranges::any_of(_systems, &SystemBase::reordered))
+                    reorder();
+                else
+                    for (size_t i = 0; i < _systems.size(); ++i)
+                        if (_schedule.enabled[i] != _systems[i]->enable) {
+                            regroup(); // toggling doesn't change the order, only what runs
+                            break;
+                        }
+                return _schedule;
+            }
+
+            void run(SystemBase& sys) {
+                RunningSystem running(&sys);
+                sys.chunkCommands.resize(_pool ? _pool->size() : 0); // before any chunk can record
+            #if DSECS_PROFILE
+                if (_profiler)
+                    sample(sys);
+                else
+                    sys.update(this);
+            #else
+                sys.update(this);
+            #endif
+                sys.lastRun = ++*_clock; // so its own writes are behind it, and any after it are not
+            }
+
+        #if DSECS_PROFILE
+            void sample(SystemBase& sys) {
+                auto commands = recorded(sys);
+                sys.visited.store(0, std::memory_order_relaxed);
+                auto start = _profiler->clock();
+                sys.update(this);
+                auto end = _profiler->clock();
+                _profiler->samples.push({ sys.trace, uint32_t(_pool ? _pool->self() : 0), start, end - start,
+                    sys.visited.load(std::memory_order_relaxed), recorded(sys) - commands });
+            }
+            static auto recorded(SystemBase const& sys) -> size_t {
+                size_t n = sys.commands.size();
+                for (auto& b : sys.chunkCommands)
+                    n += b.size();
+                return n;
+            }
+        #endif
+
+            void apply(CommandBuffer& b) {
+                b.applying();
+                for (EntityIndex i = 0; i < b.spawns; ++i)
+                    b.spawned.push_back(newEntity());
+                for (auto& q : b.queues)
+                    if (q)
+                        q->apply(*this, b);
+                for (auto& e : b.kills)
+                    e = b.resolve(e);
+                killBatch(b.kills);
+                b.clear();
+            }
 
         public:
+            // the memory must outlive the world, and any manager handed out by it
+            World(std::pmr::memory_resource* memory = std::pmr::get_default_resource())
+                : _memory(memory), _slots(1, EntitySlot{}, memory), _alive(memory), _free(memory), _components(memory),
+                  _signatures(std::allocate_shared<Signatures>(std::pmr::polymorphic_allocator<>(memory), memory)),
+                  _clock(std::allocate_shared<Clock>(std::pmr::polymorphic_allocator<>(memory), 1)),
+                  _entityNames(std::allocate_shared<NameIndex>(std::pmr::polymorphic_allocator<>(memory), memory)),
+                  _victimsBy(memory) { }
+
+            auto memory() const -> std::pmr::memory_resource* { return _memory; }
+
             /* trinity */
 
-            auto newEntity() -> Entity { return _nextEntity++; }
+            auto newEntity() -> Entity {
+                EntityIndex i;
+                if (!_free.empty()) {
+                    i = _free.back();
+                    _free.pop_back();
+                } else {
+                    i = EntityIndex(_slots.size());
+                    _slots.emplace_back();
+                }
+                auto e = makeEntity(i, _slots[i].generation);
+                _signatures->issue(e);
+                _slots[i].alive = uint32_t(_alive.size());
+                _alive.push_back(e);
+                return e;
+            }
+
+            // makes `n` entities at once, reusing dead indices first and then growing every array once
+            // returns a copy of the new entities, the alive list they are packed at the end of moves as entities come and go
+            auto newEntities(size_t n) -> std::vector<Entity> {
+                auto first = _alive.size();
+                growTo(_alive, first + n);
+                for (; n > 0 && !_free.empty(); --n)
+                    newEntity();
+                auto i = EntityIndex(_slots.size());
+                _slots.resize(_slots.size() + n);
+                growTo(_signatures->bits, _slots.size());
+                for (auto end = i + EntityIndex(n); i < end; ++i) {
+                    _slots[i].alive = uint32_t(_alive.size());
+                    _alive.push_back(makeEntity(i, 0));
+                }
+                return { _alive.begin() + first, _alive.end() };
+            }
+
+            auto isAlive(Entity e) const -> bool {
+                auto i = entityIndex(e);
+                return i < _slots.size() && _slots[i].alive != EntitySlot{}.alive && _slots[i].generation == entityGeneration(e);
+            }
 
             template<typename TComp>
             auto requireComponent() -> std::shared_ptr<ComponentManager<TComp>> {
-                auto key = typeid(TComp).hash_code();
-                if (auto it = _components.find(key); it != _components.end())
-                    // this static cast is safe because we index by typeid
-                    return std::static_pointer_cast<ComponentManager<TComp>>(it->second);
-                auto res = std::make_shared<ComponentManager<TComp>>(typeid(TComp).name());
-                _components[key] = res;
+                auto id = componentId<TComp>();
+                if (id < _components.size() && _components[id])
+                    // this static cast is safe because we index by component id
+                    return std::static_pointer_cast<ComponentManager<TComp>>(_components[id]);
+                if (id >= MaxComponents) // before growing, so a refused type leaves the world as it was
+                    throw std::length_error("World::requireComponent more component types than DSECS_MAX_COMPONENTS");
+                if (id >= _components.size())
+                    _components.resize(id + 1);
+                auto res = std::allocate_shared<ComponentManager<TComp>>(std::pmr::polymorphic_allocator<>(_memory), typeName<TComp>(), _memory);
+                res->id = id;
+                res->signatures = _signatures;
+                res->clock = _clock;
+                if constexpr (std::is_same_v<TComp, Name>) {
+                    res->values.interner = _entityNames.get();
+                    res->index = _entityNames;
+                }
+                _components[id] = res;
                 return res;
             }
 
-            auto allEntities() { return std::ranges::iota_view(1u, _nextEntity); }
+            auto allEntities() { return _alive | std::views::all; }
+
+            // calls `f(entity)` for every entity with all of the tags, their bits are intersected 64 entities at a time
+            template<TagComponent... TTags, std::invocable<Entity> F>
+            void eachTagged(F&& f) {
+                BitSet<Entity> const* sets[] = { &requireComponent<TTags>()->values... };
+                BitSet<Entity>::eachOf(sets, [&](size_t i) { f(makeEntity(EntityIndex(i), _slots[i].generation)); });
+            }
+            template<TagComponent... TTags>
+            auto countTagged() -> size_t {
+                BitSet<Entity> const* sets[] = { &requireComponent<TTags>()->values... };
+                return BitSet<Entity>::countOf(sets);
+            }
+
+            template<typename... TComps>
+            auto query() -> Query<TComps...> {
+                auto sys = RunningSystem::system();
+                return query<TComps...>(sys ? sys->lastRun : 0);
+            }
+            // Changed terms match writes at or after `since`, a system's queries use when it last ran
+            template<typename... TComps>
+            auto query(Tick since) -> Query<TComps...> {
+                auto q = Query<TComps...>(_pool.get(), since, requireComponent<QueryComponent<TComps>>().get()...);
+            #if DSECS_PROFILE
+                if (_profiler && RunningSystem::system())
+                    q.visited = &RunningSystem::system()->visited;
+            #endif
+                return q;
+            }
+            auto now() const -> Tick { return *_clock; }
+
+            // every system in the order they run, phase by phase, meeting their before and after constraints
+            auto systemOrder() {
+                return schedule().order | std::views::transform([this](size_t i) { return _systems[i].get(); });
+            }
+
+            // the independent sets of enabled systems, none in a batch conflict or are ordered, each batch runs after
+            // every earlier one
+            auto systemBatches() -> std::vector<std::vector<SystemBase*>> const& { return schedule().batches; }
+
+            // advances every enabled system by `dt` seconds, running those that are due, see SystemBase::due
+            void update(Seconds dt = 0) {
+            #if DSECS_PROFILE
+                if (_profiler)
+                    for (auto& sys : _systems)
+                        _profiler->enroll(sys->name, sys->trace);
+            #endif
+                if (!_pool) {
+                    for (auto sys : systemOrder() | std::views::filter(&SystemBase::enable))
+                        for (auto steps = sys->due(dt); steps > 0; --steps) {
+                            run(*sys);
+                            notify();
+                        }
+                } else {
+                    for (auto& batch : systemBatches()) {
+                        _pool->parallelFor(batch.size(), [&](size_t i) {
+                            for (auto steps = batch[i]->due(dt); steps > 0; --steps)
+                                run(*batch[i]);
+                        });
+                        notify();
+                    }
+                }
+                flush();
+            }
+
+            // the time the running system's current run covers
+            auto deltaTime() const -> Seconds { return RunningSystem::system() ? RunningSystem::system()->delta : 0; }
+
+            // the total number of threads to update with, including the calling one, 1 disables the pool
+            void useThreads(size_t threads) {
+                flush();
+                _pool = (threads > 1) ? std::make_unique<ThreadPool>(threads - 1) : nullptr;
+                _commands.resize(_pool ? _pool->size() : 1);
+            }
+            auto threadPool() -> ThreadPool* { return _pool.get(); }
+
+            // starts sampling every system run into a fresh profiler keeping the latest `capacity` samples
+            // needs DSECS_PROFILE, without it this does nothing and returns null
+        #if DSECS_PROFILE
+            auto profile(size_t capacity = size_t(1) << 16) -> Profiler* {
+                _profiler = std::make_unique<Profiler>(capacity);
+                for (auto& sys : _systems)
+                    sys->trace = Profiler::NoTrace;
+                return _profiler.get();
+            }
+            void stopProfiling() { _profiler.reset(); }
+            auto profiler() -> Profiler* { return _profiler.get(); }
+        #else
+            auto profile(size_t = 0) -> Profiler* { return nullptr; }
+            void stopProfiling() { }
+            auto profiler() -> Profiler* { return nullptr; }
+        #endif
+
+            // the command buffer of the system running on this thread, or this thread's own outside of one
+            // the chunks of a system's parallel query each record into the system's buffer for their thread
+            auto commands() -> CommandBuffer& {
+                auto thread = _pool ? _pool->self() : 0;
+                if (auto sys = RunningSystem::system())
+                    return RunningSystem::chunk() ? sys->chunkCommands[thread] : sys->commands;
+                return _commands[thread];
+            }
+
+            // the real entity for a placeholder from any of this world's command buffers, once its commands are applied
+            auto resolve(Entity e) const -> Entity {
+                if (!CommandBuffer::isPending(e))
+                    return e;
+                for (auto& b : _commands)
+                    if (b.owns(e))
+                        return b.resolve(e);
+                for (auto& sys : _systems) {
+                    if (sys->commands.owns(e))
+                        return sys->commands.resolve(e);
+                    for (auto& b : sys->chunkCommands)
+                        if (b.owns(e))
+                            return b.resolve(e);
+                }
+                throw std::invalid_argument("World::resolve placeholder of no command buffer in this world");
+            }
 
-            void update() {
-                for (auto sys : _systems | std::views::filter(&SystemBase::enable)) {
-                    sys->update(this);
+            // the sync point, applies every pending command buffer in system order
+            void flush() {
+                for (auto& b : _commands)
+                    if (!b.empty())
+                        apply(b);
+                for (auto sys : systemOrder()) {
+                    if (!sys->commands.empty())
+                        apply(sys->commands);
+                    for (auto& b : sys->chunkCommands)
+                        if (!b.empty())
+                            apply(b);
                 }
+                notify();
+            }
+
+            // observers get each component's events as spans, in order, whenever the world reaches a system boundary
+            // they run on the updating thread between systems, so they may change the world directly
+            template<typename TComp>
+            void observe(ComponentEvent k, Observer f) {
+                auto manager = requireComponent<TComp>();
+                if (std::ranges::find(_observed, manager.get()) == _observed.end())
+                    _observed.push_back(manager.get());
+                manager->observe(k, std::move(f));
+            }
+            template<typename TComp>
+            void onAdd(Observer f) { observe<TComp>(ComponentEvent::Add, std::move(f)); }
+            template<typename TComp>
+            void onSet(Observer f) { observe<TComp>(ComponentEvent::Set, std::move(f)); }
+            template<typename TComp>
+            void onRemove(Observer f) { observe<TComp>(ComponentEvent::Remove, std::move(f)); }
+
+            // delivers the events recorded since the last boundary, update and flush do this on their own
+            void notify() {
+                for (auto m : _observed)
+                    m->notify();
             }
         
             template<std::invocable<World*> FExec>
             auto makeSystem(std::string_view name, FExec exec) -> std::shared_ptr<SystemAnonymous<FExec>> {
                 auto res = std::make_shared<SystemAnonymous<FExec>>(name, exec);
                 _systems.emplace_back(res);
+                _systemNames.try_emplace(std::string(name), res);
+                _schedule.stale = true;
                 return res;
             }
 
-            /* ergonomics I */
+            // a system with declared access, it may run alongside others and must defer structural changes to commands()
+            template<typename... TComps, std::invocable<World*> FExec>
+            auto makeSystem(std::string_view name, Access<TComps...>, FExec exec) -> std::shared_ptr<SystemAnonymous<FExec>> {
+                (requireComponent<QueryComponent<TComps>>(), ...); // so a parallel update never creates managers
+                ((QueryTerm<TComps>::changed ? requireComponent<QueryComponent<TComps>>()->track() : void()), ...); // nor starts tracking
+                auto res = makeSystem(name, exec);
+                Access<TComps...>::declare(*res);
+                return res;
+            }
 
-            auto findEntity(std::string_view name) -> Entity {
-                auto it = _entityNames.find(name);
-                return (it != _entityNames.end()) ? it->second : NoEntity;
+            // a system over a single query, with access inferred from the query's components
+            template<typename... TComps, std::invocable<Entity, QueryRef<TComps>...> FEach> requires (sizeof...(TComps) > 0)
+            auto makeSystem(std::string_view name, FEach each) {
+                return makeSystem(name, Access<TComps...>{}, [each](World* w) {
+                    w->query<TComps...>().each(each);
+                });
             }
 
+            // a system over the contiguous runs of a single query, see Query::batches
+            template<typename... TComps, std::invocable<std::span<Entity const>, QueryBlock<TComps>...> FBatch> requires (sizeof...(TComps) > 0)
+            auto makeBatchSystem(std::string_view name, FBatch batch) {
+                return makeSystem(name, Access<TComps...>{}, [batch](World* w) {
+                    w->query<TComps...>().batches(batch);
+                });
+            }
+
+            /* ergonomics I */
+
+            // never allocates, the index forgets an entity as soon as it is killed
+            auto findEntity(std::string_view name) const -> Entity { return _entityNames->find(name); }
+
             auto requireEntity(std::string_view name) -> Entity {
                 // early exit if the name already exists
-                // we don't attempt to reuse this lookup in this case because the string view in the index must come from the component for a safe lifetime.
                 if (auto e = findEntity(name); e != NoEntity)
                     return e;
                 
                 auto e = newEntity();
-                std::string_view name_str = (requireComponent<Name>()->values[e] = { std::string(name) }).name;
-                return _entityNames[name_str] = e;
+                requireComponent<Name>()->set(e, { name });
+                return e;
             }
 
-            auto allComponents() { return _components | std::views::values; }
+            auto namedEntities() const -> size_t { return _entityNames->size(); }
+
+            // skips the ids of components this world never required
+            auto allComponents() { return _components | std::views::filter([](auto const& c) { return c != nullptr; }); }
 
             auto allSystems() { return _systems | std::views::all; }
 
-            auto findSystem(std::string_view name) -> std::shared_ptr<SystemBase> { 
-                auto it = std::ranges::find_if(_systems, [&](auto s){ return s->name == name; });
-                return (it != _systems.end()) ? *it : nullptr;
+            auto findSystem(std::string_view name) -> std::shared_ptr<SystemBase> {
+                auto it = _systemNames.find(std::string(name));
+                return (it != _systemNames.end()) ? it->second : nullptr;
+            }
+
+            // removes the first system made with the name, not while updating
+            auto removeSystem(std::string_view name) -> bool {
+                auto it = _systemNames.find(std::string(name));
+                if (it == _systemNames.end())
+                    return false;
+                std::erase(_systems, it->second);
+                _systemNames.erase(it);
+                // the next system with the name, if any, takes its place
+                if (auto next = std::ranges::find_if(_systems, [&](auto& s) { return s->name == name; }); next != _systems.end())
+                    _systemNames.emplace(std::string(name), *next);
+                _schedule.stale = true;
+                return true;
             }
 
+            // only the managers in the entity's signature are touched
             void kill(Entity e) {
-                for (auto c : allComponents())
-                    if (c->has(e))
-                        c->del(e);
+                if (!isAlive(e))
+                    return;
+                auto sig = signature(e);
+                for (ComponentId c = 0; c < _components.size() && sig.any(); ++c)
+                    if (sig[c]) {
+                        _components[c]->del(e);
+                        sig.reset(c);
+                    }
+                release(e);
+            }
+
+            // kills many at once, each manager is visited once for all of its victims
+            void kill(std::span<Entity const> es) { killBatch(es); }
+
+            /* signatures */
+
+            auto signature(Entity e) const -> Signature { return isAlive(e) ? _signatures->of(entityIndex(e)) : Signature{}; }
+
+            // whether the entity has every component in `with` and none in `without`
+            auto matches(Entity e, Signature const& with, Signature const& without = {}) const -> bool {
+                auto sig = signature(e);
+                return (sig & with) == with && (sig & without).none();
             }
+
+            template<typename... TComps>
+            auto has(Entity e) const -> bool { return matches(e, signatureOf<TComps...>()); }
     };
+
+    /* deferred command application */
+
+    template<typename TComp>
+    void CommandQueue<TComp>::apply(World& w, CommandBuffer const& b) {
+        auto manager = w.requireComponent<TComp>();
+        for (auto& [e, v] : ops) {
+            auto real = b.resolve(e);
+            if (!w.isAlive(real))
+                continue;
+            if (v)
+                manager->set(real, std::move(*v));
+            else
+                manager->del(real);
+        }
+    }
 }
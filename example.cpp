@@ -54,30 +54,24 @@ int main()
 
     auto health = world.requireComponent<HealthStatus>();
 
-    world.makeSystem("acceleration", [=](World* w) {
-        for (auto& [e, a] : acl->values) {
-            vel->with(e, [=](auto& v) {
-                v.x += a.x;
-                v.y += a.y;
-            });
-        }
+    world.useThreads(std::thread::hardware_concurrency());
+
+    world.makeSystem<Acceleration const, Velocity>("acceleration", [](Entity e, auto& a, auto& v) {
+        v.x += a.x;
+        v.y += a.y;
     });
 
-    world.makeSystem("velocity", [=](World* w) {
-        for (auto& [e, v] : vel->values) {
-            pos->with(e, [=](auto& p) {
-                p.x += v.x;
-                p.y += v.y;
-            });
-        }
+    world.makeSystem<Velocity const, Position>("velocity", [](Entity e, auto& v, auto& p) {
+        p.x += v.x;
+        p.y += v.y;
     });
 
-    world.makeSystem("health-tick", [=](World* w) {
-        for (auto& [e, h] : health->values) {
+    world.makeSystem("health-tick", Access<HealthStatus>{}, [=](World* w) {
+        for (auto&& [e, h] : health->values) {
             double health_point_pct = 1.0 / h.maximum;  // to prevent dividing multiple times
             h.current_pct += h.delta * health_point_pct;
             if (h.current_pct <= 0.5 * health_point_pct) // less than 0.5 health points, this is effectively our epsilon.
-                w->kill(e); // our iterator is now invalidated, the h (and e!) above are now invalid because they were taken by reference.
+                w->commands().kill(e); // deferred until the end of the update, so our iteration stays valid.
         }
     });
 
@@ -1,7 +1,10 @@
+#define DSECS_PROFILE 1 // the profiling test needs it, every other test runs the same either way
 #define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
 #include "catch2/catch.hpp"
+#include <set>
 
 #include "dsecs.hpp"
+#include "2a_archetypes/dsecs_2a.hpp"
 
 using namespace dsecs;
 
@@ -18,3 +21,1009 @@ TEST_CASE("Component Managers are Stable", "[components]" ) {
     REQUIRE( a0 != nullptr );
     REQUIRE( a0 == a1 );
 }
+
+TEST_CASE("Component ids are dense and stable", "[components]" ) {
+    auto a = componentId<TestComponentA>();
+    auto n = componentId<size_t>();
+
+    REQUIRE( a != n );
+    REQUIRE( componentId<TestComponentA>() == a );
+    REQUIRE( typeName<TestComponentA>() == "TestComponentA" );
+
+    World w;
+    w.requireComponent<size_t>();
+    REQUIRE( std::ranges::distance(w.allComponents()) == 1 );
+    REQUIRE( (*w.allComponents().begin())->name == typeName<size_t>() );
+}
+
+TEST_CASE("Sparse Sets pack values densely", "[components]" ) {
+    SparseSet<Entity, size_t> s;
+
+    s[3] = 30;
+    s[1] = 10;
+    s.insert_or_assign(7, 70);
+
+    REQUIRE( s.size() == 3 );
+    REQUIRE( s.contains(1) );
+    REQUIRE( !s.contains(2) );
+    REQUIRE( s.at(7) == 70 );
+
+    REQUIRE( s.erase(3) == 1 );
+    REQUIRE( s.erase(3) == 0 );
+    REQUIRE( s.size() == 2 );
+    REQUIRE( s.at(1) == 10 );
+    REQUIRE( s.at(7) == 70 );
+
+    size_t sum = 0;
+    for (auto&& [e, v] : s)
+        sum += e + v;
+    REQUIRE( sum == 1 + 10 + 7 + 70 );
+}
+
+TEST_CASE("Flat Maps pack values densely", "[components]" ) {
+    FlatMap<Entity, size_t> s;
+
+    for (Entity k = 1; k <= 100; ++k)
+        s[k << 32 | k] = k * 10; // high bits would make a sparse index huge
+    REQUIRE( s.size() == 100 );
+    REQUIRE( s.buckets.size() == 128 );
+    REQUIRE( s.at(7ull << 32 | 7) == 70 );
+    REQUIRE( !s.contains(7) );
+    REQUIRE_THROWS_AS( s.emplace(7ull << 32 | 7), std::invalid_argument );
+
+    for (Entity k = 1; k <= 100; k += 2)
+        REQUIRE( s.erase(k << 32 | k) == 1 );
+    REQUIRE( s.erase(1ull << 32 | 1) == 0 );
+    REQUIRE( s.size() == 50 );
+
+    size_t sum = 0;
+    for (auto&& [k, v] : s) {
+        REQUIRE( s.at(k) == v );
+        sum += v;
+    }
+    REQUIRE( sum == 10 * 50 * 51 );
+}
+
+TEST_CASE("Archetypes move rows between tables", "[archetypes]" ) {
+    dsecs2a::World w;
+
+    auto a = w.requireComponent<TestComponentA>();
+    auto e0 = w.newEntity();
+    auto e1 = w.newEntity();
+    a->set(e0, { 1 });
+    a->set(e1, { 2 });
+    w.set<size_t>(e1, 20);
+
+    REQUIRE( a->get(e0).a_number == 1 );
+    REQUIRE( a->get(e1).a_number == 2 );
+    REQUIRE( *w.find<size_t>(e1) == 20 );
+    REQUIRE( w.find<size_t>(e0) == nullptr );
+
+    size_t count = 0;
+    w.each<TestComponentA, size_t>([&](auto e, auto& ta, auto& n) {
+        REQUIRE( e == e1 );
+        ++count;
+    });
+    REQUIRE( count == 1 );
+
+    a->del(e1);
+    REQUIRE( !a->has(e1) );
+    REQUIRE( *w.find<size_t>(e1) == 20 );
+
+    w.kill(e0);
+    REQUIRE( !a->has(e0) );
+    REQUIRE( *w.find<size_t>(e1) == 20 );
+}
+
+TEST_CASE("Queries join on the smallest manager", "[queries]" ) {
+    World w;
+
+    auto a = w.requireComponent<TestComponentA>();
+    auto n = w.requireComponent<size_t>();
+
+    for (size_t i = 0; i < 8; ++i) {
+        auto e = w.newEntity();
+        a->set(e, { i });
+        if (i % 4 == 0)
+            n->set(e, i * 10);
+    }
+
+    auto q = w.query<TestComponentA, size_t const>();
+    REQUIRE( q.driver == 1 );
+
+    size_t count = 0;
+    for (auto [e, ta, tn] : q) {
+        REQUIRE( ta.a_number * 10 == tn );
+        ta.a_number += 1;
+        ++count;
+    }
+    REQUIRE( count == 2 );
+    REQUIRE( a->get(1).a_number == 1 );
+    REQUIRE( a->get(5).a_number == 5 );
+    REQUIRE( a->get(2).a_number == 1 );
+}
+
+TEST_CASE("Entities are recycled with a new generation", "[entities]" ) {
+    World w;
+
+    auto a = w.requireComponent<TestComponentA>();
+    auto e0 = w.newEntity();
+    auto e1 = w.newEntity();
+    a->set(e0, { 0 });
+    a->set(e1, { 1 });
+
+    REQUIRE( w.isAlive(e0) );
+    REQUIRE( !w.isAlive(NoEntity) );
+
+    w.kill(e0);
+    REQUIRE( !w.isAlive(e0) );
+    REQUIRE( std::ranges::distance(w.allEntities()) == 1 );
+
+    auto e2 = w.newEntity();
+    REQUIRE( entityIndex(e2) == entityIndex(e0) );
+    REQUIRE( entityGeneration(e2) == entityGeneration(e0) + 1 );
+    REQUIRE( !w.isAlive(e0) );
+    REQUIRE( w.isAlive(e2) );
+
+    a->set(e2, { 2 });
+    REQUIRE( !a->has(e0) );
+    REQUIRE( a->get(e2).a_number == 2 );
+    REQUIRE( a->get(e1).a_number == 1 );
+
+    w.kill(e0); // stale handles are ignored
+    REQUIRE( w.isAlive(e2) );
+    REQUIRE( std::ranges::distance(w.allEntities()) == 2 );
+}
+
+struct TestTagStale { };
+
+TEST_CASE("Managers refuse stale handles", "[entities]" ) {
+    World w;
+    auto a = w.requireComponent<TestComponentA>();
+    auto tag = w.requireComponent<TestTagStale>();
+
+    auto dead = w.newEntity();
+    w.kill(dead);
+    REQUIRE_THROWS_AS( a->set(dead, { 0 }), std::invalid_argument ); // dead, index not reused yet
+
+    auto reused = w.newEntity();
+    REQUIRE( entityIndex(reused) == entityIndex(dead) );
+    REQUIRE_THROWS_AS( a->set(dead, { 0 }), std::invalid_argument );
+    std::array batch = { reused, dead };
+    REQUIRE_THROWS_AS( a->setRange(batch), std::invalid_argument );
+    REQUIRE_THROWS_AS( tag->set(dead), std::invalid_argument );
+    REQUIRE( !a->has(reused) );
+    REQUIRE( !w.has<TestComponentA>(reused) );
+    REQUIRE( !tag->has(reused) );
+
+    a->set(reused, { 1 });
+    REQUIRE( a->get(reused).a_number == 1 );
+    REQUIRE( w.has<TestComponentA>(reused) );
+    size_t rows = 0;
+    for (auto [e, ta] : w.query<TestComponentA>()) {
+        REQUIRE( e == reused );
+        ++rows;
+    }
+    REQUIRE( rows == 1 );
+
+    // tag bits only keep the index, a stale handle still mustn't answer for or change the entity that reused it
+    tag->set(reused);
+    REQUIRE( tag->has(reused) );
+    REQUIRE( !tag->has(dead) );
+    REQUIRE_THROWS_AS( tag->get(dead), std::out_of_range );
+    size_t calls = 0;
+    tag->with(dead, [&](auto) { ++calls; });
+    REQUIRE( calls == 0 );
+    tag->del(dead);
+    tag->delMany(std::span(&dead, 1));
+    REQUIRE( tag->has(reused) );
+    REQUIRE( w.has<TestTagStale>(reused) );
+
+    // killing in a batch still clears the tags of the dying
+    std::array both = { reused, reused };
+    w.kill(both);
+    REQUIRE( tag->values.empty() );
+    REQUIRE( a->values.size() == 0 );
+}
+
+TEST_CASE("Signatures follow every change to the managers", "[entities]" ) {
+    World w;
+
+    auto a = w.requireComponent<TestComponentA>();
+    auto n = w.requireComponent<size_t>();
+    auto e0 = w.newEntity();
+    auto e1 = w.newEntity();
+    a->set(e0, { 0 });
+    n->values[e0] = 1;
+    a->values[e1] = { 1 };
+
+    REQUIRE( w.has<TestComponentA, size_t>(e0) );
+    REQUIRE( !w.has<TestComponentA, size_t>(e1) );
+    REQUIRE( w.matches(e1, signatureOf<TestComponentA>(), signatureOf<size_t>()) );
+    REQUIRE( w.signature(e0).count() == 2 );
+
+    n->values.erase(e0);
+    REQUIRE( w.signature(e0) == signatureOf<TestComponentA>() );
+
+    w.kill(e0);
+    REQUIRE( !a->has(e0) );
+    REQUIRE( w.signature(e0).none() );
+
+    // the recycled index starts out empty
+    auto e2 = w.newEntity();
+    REQUIRE( entityIndex(e2) == entityIndex(e0) );
+    REQUIRE( w.signature(e2).none() );
+    REQUIRE( w.has<TestComponentA>(e1) );
+}
+
+TEST_CASE("Command buffers defer structural changes", "[commands]" ) {
+    World w;
+
+    auto a = w.requireComponent<TestComponentA>();
+    auto e0 = w.newEntity();
+    auto e1 = w.newEntity();
+    a->set(e0, { 0 });
+    a->set(e1, { 1 });
+
+    Entity spawned = NoEntity;
+    w.makeSystem("defer", [&](World* w) {
+        for (auto [e, ta] : w->query<TestComponentA>()) {
+            if (ta.a_number == 0)
+                w->commands().kill(e);
+        }
+        auto s = w->commands().spawn();
+        w->commands().set<TestComponentA>(s, { 7 });
+        w->commands().del<TestComponentA>(e1);
+        spawned = s;
+    });
+
+    w.update();
+
+    REQUIRE( !w.isAlive(e0) );
+    REQUIRE( w.isAlive(e1) );
+    REQUIRE( !a->has(e1) );
+    REQUIRE( a->values.size() == 1 );
+    REQUIRE( CommandBuffer::isPending(spawned) );
+    REQUIRE( std::ranges::distance(w.allEntities()) == 2 );
+    for (auto [e, ta] : w.query<TestComponentA>())
+        REQUIRE( ta.a_number == 7 );
+
+    // the placeholder resolves to what was made for it, until the buffer applies again
+    auto real = w.resolve(spawned);
+    REQUIRE( w.isAlive(real) );
+    REQUIRE( a->get(real).a_number == 7 );
+    REQUIRE( w.findSystem("defer")->commands.resolve(spawned) == real );
+
+    // placeholders only belong to the buffer and the batch that made them
+    CommandBuffer other;
+    REQUIRE_THROWS_AS( other.set<TestComponentA>(spawned, { 1 }), std::invalid_argument );
+    REQUIRE_THROWS_AS( other.resolve(spawned), std::invalid_argument );
+    auto pending = other.spawn();
+    REQUIRE_THROWS_AS( other.resolve(pending), std::invalid_argument ); // not applied yet
+    REQUIRE_THROWS_AS( w.commands().kill(pending), std::invalid_argument );
+    REQUIRE_THROWS_AS( w.resolve(pending), std::invalid_argument );
+
+    auto first = spawned;
+    w.update(); // the system spawns again, the first placeholder is stale now
+    REQUIRE( spawned != first );
+    REQUIRE_THROWS_AS( w.resolve(first), std::invalid_argument );
+    REQUIRE( a->get(w.resolve(spawned)).a_number == 7 );
+}
+
+TEST_CASE("Systems with disjoint access share a batch", "[systems]" ) {
+    World w;
+    w.useThreads(4);
+
+    auto a = w.requireComponent<TestComponentA>();
+    auto n = w.requireComponent<size_t>();
+    for (size_t i = 0; i < 1000; ++i) {
+        auto e = w.newEntity();
+        a->set(e, { i });
+        n->set(e, size_t(i));
+    }
+
+    w.makeSystem<TestComponentA>("a", [](Entity e, auto& ta) { ta.a_number += 1; });
+    w.makeSystem<size_t>("n", [](Entity e, auto& tn) { tn += 2; });
+    w.makeSystem<TestComponentA const, size_t>("both", [](Entity e, auto& ta, auto& tn) { tn += ta.a_number; });
+    w.makeSystem("anything", [](World* w) { });
+
+    auto batches = w.systemBatches();
+    REQUIRE( batches.size() == 3 );
+    REQUIRE( batches[0].size() == 2 );
+    REQUIRE( batches[1][0]->name == "both" );
+    REQUIRE( batches[2][0]->name == "anything" );
+
+    w.update();
+    REQUIRE( a->get(1).a_number == 1 );
+    REQUIRE( n->get(1) == 0 + 2 + 1 );
+    REQUIRE( n->get(1000) == 999 + 2 + 1000 );
+}
+
+TEST_CASE("Parallel queries visit every match once", "[queries]" ) {
+    World w;
+    w.useThreads(4);
+
+    auto a = w.requireComponent<TestComponentA>();
+    auto n = w.requireComponent<size_t>();
+    for (size_t i = 0; i < 10000; ++i) {
+        auto e = w.newEntity();
+        a->set(e, { i });
+        if (i % 3 == 0)
+            n->set(e, size_t(0));
+    }
+
+    std::atomic<size_t> count = 0;
+    w.query<TestComponentA const, size_t>().par([&](Entity e, auto& ta, auto& tn) {
+        tn = ta.a_number;
+        ++count;
+        if (ta.a_number % 2 == 0)
+            w.commands().kill(e);
+    }, 64);
+
+    REQUIRE( count == 3334 );
+    for (auto [e, tn] : w.query<size_t const>())
+        REQUIRE( a->get(e).a_number == tn );
+
+    w.flush();
+    REQUIRE( n->values.size() == 1667 );
+    REQUIRE( std::ranges::distance(w.allEntities()) == 10000 - 1667 );
+}
+
+TEST_CASE("Parallel chunks run for the system that made them", "[queries]" ) {
+    World w;
+    w.useThreads(4);
+
+    auto a = w.requireComponent<TestComponentA>();
+    auto n = w.requireComponent<size_t>();
+    for (size_t i = 0; i < 10000; ++i) {
+        auto e = w.newEntity();
+        a->set(e, { i });
+        if (i < 10)
+            n->set(e, size_t(i));
+    }
+
+    std::atomic<size_t> changed = 0;
+    std::mutex lock;
+    std::vector<Entity> spawned;
+    w.makeSystem("chunks", Access<TestComponentA const, Changed<size_t const>>{}, [&](World* w) {
+        w->query<TestComponentA const>().par([&](Entity e, auto const& ta) {
+            // queries made inside a chunk compare against the system's last run too
+            for (auto row : w->query<Changed<size_t const>>())
+                ++changed;
+            if (ta.a_number % 1000 == 0) {
+                std::scoped_lock l(lock);
+                spawned.push_back(w->commands().spawn());
+            }
+        }, 64);
+    });
+
+    w.update();
+    REQUIRE( changed == 10 * 10000 ); // never ran, so everything is new to it
+    changed = 0;
+    spawned.clear();
+    w.update();
+    REQUIRE( changed == 0 );
+
+    // recorded into the system's own buffers, so they resolve through the world once applied
+    REQUIRE( spawned.size() == 10 );
+    std::set<Entity> real;
+    for (auto p : spawned)
+        real.insert(w.resolve(p));
+    REQUIRE( real.size() == 10 );
+    REQUIRE( std::ranges::all_of(real, [&](Entity e) { return w.isAlive(e); }) );
+}
+
+struct TestComponentV {
+    float x, y;
+};
+
+template<> struct dsecs::SoaLayout<TestComponentV> {
+    static constexpr auto fields = std::tuple{ &TestComponentV::x, &TestComponentV::y };
+    struct Ref { float& x; float& y; };
+};
+
+TEST_CASE("Struct of arrays components split their fields", "[components]" ) {
+    World w;
+
+    auto v = w.requireComponent<TestComponentV>();
+    auto a = w.requireComponent<TestComponentA>();
+    for (size_t i = 0; i < 4; ++i) {
+        auto e = w.newEntity();
+        v->set(e, { float(i), float(i) * 2 });
+        a->set(e, { i });
+    }
+
+    REQUIRE( std::ranges::equal(v->values.field<0>(), std::vector<float>{ 0, 1, 2, 3 }) );
+    REQUIRE( std::ranges::equal(v->values.field<1>(), std::vector<float>{ 0, 2, 4, 6 }) );
+
+    for (auto [e, tv, ta] : w.query<TestComponentV, TestComponentA const>())
+        tv.y += ta.a_number;
+    REQUIRE( v->get(4).y == 9 );
+
+    v->mut(1).x = 10;
+    v->del(2);
+    REQUIRE( !v->has(2) );
+    REQUIRE( v->get(1).x == 10 );
+    REQUIRE( std::ranges::equal(v->values.field<0>(), std::vector<float>{ 10, 3, 2 }) );
+}
+
+TEST_CASE("Batches hand out contiguous runs in place", "[queries]" ) {
+    World w;
+
+    auto v = w.requireComponent<TestComponentV>();
+    auto n = w.requireComponent<size_t>();
+    for (size_t i = 0; i < 300; ++i) {
+        auto e = w.newEntity();
+        v->set(e, { float(i), 0 });
+        n->set(e, size_t(i));
+    }
+
+    size_t runs = 0, count = 0;
+    w.query<TestComponentV, size_t const>().batches([&](auto es, auto tvs, std::span<size_t const> tns) {
+        auto [xs, ys] = tvs;
+        REQUIRE( xs.size() == es.size() );
+        for (size_t i = 0; i < tns.size(); ++i)
+            ys[i] = float(tns[i]);
+        ++runs;
+        count += es.size();
+    });
+    REQUIRE( runs == 1 );
+    REQUIRE( count == 300 );
+    REQUIRE( v->get(300).y == 299 );
+
+    // swap-and-pop moves the last of one manager but not the other, splitting the run around it
+    n->del(100);
+    runs = count = 0;
+    w.query<TestComponentV const, size_t const>().batches([&](auto es, auto tvs, auto tns) {
+        REQUIRE( std::get<0>(tvs)[0] == float(tns[0]) );
+        ++runs;
+        count += es.size();
+    });
+    REQUIRE( runs == 3 );
+    REQUIRE( count == 299 );
+}
+
+TEST_CASE("Entities and components are made in bulk", "[entities]" ) {
+    World w;
+
+    auto a = w.requireComponent<TestComponentA>();
+    auto v = w.requireComponent<TestComponentV>();
+    auto e0 = w.newEntity();
+    w.kill(e0);
+
+    auto es = w.newEntities(100);
+    REQUIRE( es.size() == 100 );
+    REQUIRE( entityIndex(es[0]) == entityIndex(e0) ); // dead indices are used up first
+    REQUIRE( entityIndex(es[99]) == 100 );
+    REQUIRE( std::ranges::all_of(es, [&](Entity e) { return w.isAlive(e); }) );
+
+    std::vector<TestComponentA> as(es.size());
+    for (size_t i = 0; i < as.size(); ++i)
+        as[i].a_number = i;
+    REQUIRE_THROWS_AS( a->setRange(es, std::span(as).first(99)), std::invalid_argument );
+    REQUIRE_THROWS_AS( v->setRange(es, std::vector<TestComponentV>(1)), std::invalid_argument );
+    REQUIRE( a->values.size() == 0 );
+    a->setRange(es, as);
+    v->setRange(std::span(es).subspan(50), { 1, 2 });
+
+    REQUIRE( a->values.size() == 100 );
+    REQUIRE( a->get(es[42]).a_number == 42 );
+    REQUIRE( v->values.size() == 50 );
+    REQUIRE( v->get(es[99]).y == 2 );
+    REQUIRE( w.has<TestComponentA, TestComponentV>(es[50]) );
+    REQUIRE( !w.has<TestComponentV>(es[49]) );
+}
+
+TEST_CASE("Batched kills only visit the managers of the victims", "[entities]" ) {
+    World w;
+
+    auto a = w.requireComponent<TestComponentA>();
+    auto n = w.requireComponent<size_t>();
+    auto es = w.newEntities(10);
+    a->setRange(es);
+    n->setRange(std::span(es).subspan(5), size_t(5));
+    std::vector<Entity> victims = { es[0], es[6], es[6], es[9], NoEntity };
+    auto survivor = es[5];
+
+    w.kill(victims);
+    REQUIRE( std::ranges::distance(w.allEntities()) == 7 );
+    REQUIRE( a->values.size() == 7 );
+    REQUIRE( n->values.size() == 3 );
+    REQUIRE( !w.isAlive(victims[1]) );
+    REQUIRE( w.has<TestComponentA, size_t>(survivor) );
+
+    w.kill(victims); // already dead
+    REQUIRE( std::ranges::distance(w.allEntities()) == 7 );
+}
+
+TEST_CASE("Worlds keep their entities and components in the memory they are given", "[memory]" ) {
+    LevelArena arena(1 << 20);
+    {
+        World w(&arena);
+        auto a = w.requireComponent<TestComponentA>();
+        auto es = w.newEntities(100);
+        a->setRange(es);
+        w.kill(std::span(es).first(50));
+        REQUIRE( a->values.size() == 50 );
+        REQUIRE( a->values.dense.get_allocator().resource() == &arena );
+
+        // the budget is a hard limit
+        REQUIRE_THROWS_AS( a->setRange(w.newEntities(100000)), std::bad_alloc );
+    }
+
+    PooledMemory pool;
+    World w(&pool);
+    auto v = w.requireComponent<TestComponentV>();
+    v->set(w.newEntity(), { 1, 2 });
+    REQUIRE( std::get<1>(v->values.columns).get_allocator().resource() == &pool );
+}
+
+struct TestComponentF {
+    using storage = FlatStorage;
+    int f;
+};
+
+TEST_CASE("Components can be kept in a flat map", "[components]" ) {
+    World w;
+
+    auto f = w.requireComponent<TestComponentF>();
+    auto a = w.requireComponent<TestComponentA>();
+    auto es = w.newEntities(10);
+    f->setRange(std::span(es).first(5), { 1 });
+    a->setRange(es);
+
+    f->mut(es[2]).f = 3;
+    REQUIRE( f->get(es[2]).f == 3 );
+    REQUIRE( w.has<TestComponentF, TestComponentA>(es[4]) );
+
+    size_t count = 0;
+    for (auto [e, tf, ta] : w.query<TestComponentF const, TestComponentA>()) {
+        ta.a_number = tf.f;
+        ++count;
+    }
+    REQUIRE( count == 5 );
+    REQUIRE( a->get(es[2]).a_number == 3 );
+
+    w.kill(es[2]);
+    REQUIRE( f->values.size() == 4 );
+    REQUIRE( !f->has(es[2]) );
+}
+
+struct TestComponentP {
+    int p;
+};
+
+template<> struct dsecs::StoragePolicy<TestComponentP> {
+    using type = FlatStorage;
+};
+
+TEST_CASE("Components pick a storage policy", "[components]" ) {
+    STATIC_REQUIRE( std::is_same_v<StoragePolicy<TestComponentA>::type, DenseStorage> );
+    STATIC_REQUIRE( std::is_same_v<StoragePolicy<TestComponentV>::type, SoaStorage> );
+    STATIC_REQUIRE( std::is_same_v<StoragePolicy<TestComponentF>::type, FlatStorage> );
+    STATIC_REQUIRE( std::is_same_v<StoragePolicy<TestComponentP>::type, FlatStorage> );
+    STATIC_REQUIRE( std::is_same_v<decltype(ComponentManager<TestComponentP>::values), FlatMap<Entity, TestComponentP>> );
+
+    World w;
+    auto p = w.requireComponent<TestComponentP>();
+    auto v = w.requireComponent<TestComponentV>();
+    auto es = w.newEntities(4);
+    p->setRange(es, { 7 });
+    v->setRange(std::span(es).first(2), { 1, 2 });
+
+    std::shared_ptr<ComponentManagerBase> base = p;
+    REQUIRE( base->has(es[3]) );
+    base->del(es[3]);
+    REQUIRE( !p->has(es[3]) );
+
+    int sum = 0;
+    for (auto [e, tp, tv] : w.query<TestComponentP const, TestComponentV const>())
+        sum += tp.p + tv.x;
+    REQUIRE( sum == 16 );
+}
+
+struct TestTagFrozen { };
+struct TestTagPlayer { };
+
+TEST_CASE("Empty components are kept as tag bits", "[components]" ) {
+    STATIC_REQUIRE( std::is_same_v<StoragePolicy<TestTagFrozen>::type, TagStorage> );
+
+    World w;
+    auto frozen = w.requireComponent<TestTagFrozen>();
+    auto a = w.requireComponent<TestComponentA>();
+    auto es = w.newEntities(200);
+    a->setRange(es);
+    for (size_t i = 0; i < es.size(); i += 2)
+        frozen->set(es[i]);
+    w.requireComponent<TestTagPlayer>()->setRange(std::span(es).subspan(100));
+
+    REQUIRE( frozen->values.size() == 100 );
+    REQUIRE( frozen->has(es[4]) );
+    REQUIRE( !frozen->has(es[5]) );
+    REQUIRE_THROWS_AS( frozen->get(es[5]), std::out_of_range );
+    REQUIRE( w.has<TestTagFrozen, TestComponentA>(es[4]) );
+
+    size_t count = 0;
+    for (auto [e, ta, tf] : w.query<TestComponentA, TestTagFrozen const>()) {
+        REQUIRE( entityIndex(e) % 2 == entityIndex(es[0]) % 2 );
+        ++count;
+    }
+    REQUIRE( count == 100 );
+
+    size_t batched = 0;
+    w.query<TestComponentA const, TestTagFrozen const>().batches([&](auto es, auto ta, auto tf) {
+        REQUIRE( tf.size() == es.size() );
+        batched += es.size();
+    });
+    REQUIRE( batched == 100 );
+
+    REQUIRE( w.countTagged<TestTagFrozen, TestTagPlayer>() == 50 );
+    std::vector<Entity> tagged;
+    w.eachTagged<TestTagFrozen, TestTagPlayer>([&](Entity e) { tagged.push_back(e); });
+    REQUIRE( tagged.size() == 50 );
+    REQUIRE( tagged.front() == es[100] );
+
+    w.kill(es[100]);
+    frozen->del(es[102]);
+    REQUIRE( w.countTagged<TestTagFrozen, TestTagPlayer>() == 48 );
+    REQUIRE( !w.has<TestTagFrozen>(es[102]) );
+
+    // several tags filter as one intersection, in iteration and in batches
+    count = 0;
+    for (auto [e, ta, tf, tp] : w.query<TestComponentA const, TestTagFrozen const, TestTagPlayer const>())
+        ++count;
+    REQUIRE( count == 48 );
+    batched = 0;
+    w.query<TestComponentA const, TestTagFrozen const, TestTagPlayer const>().batches([&](auto es, auto ta, auto tf, auto tp) {
+        batched += es.size();
+    });
+    REQUIRE( batched == 48 );
+
+    // clearing the bits tells observers the whole entity, generation and all
+    auto player = w.requireComponent<TestTagPlayer>();
+    auto again = w.newEntity();
+    REQUIRE( entityIndex(again) == entityIndex(es[100]) );
+    player->set(again);
+    std::vector<Entity> removed;
+    w.onRemove<TestTagPlayer>([&](auto es) { removed.insert(removed.end(), es.begin(), es.end()); });
+    player->values.clear();
+    w.flush();
+    REQUIRE( removed.size() == 100 );
+    REQUIRE( std::ranges::find(removed, again) != removed.end() );
+    REQUIRE( !w.has<TestTagPlayer>(again) );
+}
+
+TEST_CASE("Changed queries visit only written entities", "[queries]" ) {
+    World w;
+    auto a = w.requireComponent<TestComponentA>();
+    auto es = w.newEntities(100);
+    a->setRange(es, { 0 });
+
+    std::vector<Entity> seen;
+    w.makeSystem<Changed<TestComponentA const>>("extract", [&](Entity e, auto const& ta) { seen.push_back(e); });
+
+    w.update();
+    REQUIRE( seen.size() == 100 ); // never ran, so everything is new to it
+
+    seen.clear();
+    w.update();
+    REQUIRE( seen.empty() );
+
+    a->mut(es[3]).a_number = 1;
+    a->set(es[7], { 2 });
+    a->with(es[9], [](auto& ta) { ta.a_number = 3; });
+    REQUIRE( a->get(es[11]).a_number == 0 ); // reads don't count
+    seen.clear();
+    w.update();
+    REQUIRE( seen == std::vector<Entity>{ es[3], es[7], es[9] } );
+
+    // a mutable query is a possible write, seen by the extract that runs after it
+    w.makeSystem<TestComponentA>("write", [&](Entity e, auto& ta) { });
+    seen.clear();
+    w.update();
+    w.update();
+    REQUIRE( seen.size() == 100 );
+
+    // the query tick can also be given directly, batches split at unchanged entities
+    auto since = w.now();
+    a->mut(es[20]);
+    a->mut(es[21]);
+    a->mut(es[40]);
+    size_t runs = 0, count = 0;
+    w.query<Changed<TestComponentA const>>(since).batches([&](auto es, auto ta) { ++runs; count += es.size(); });
+    REQUIRE( runs == 2 );
+    REQUIRE( count == 3 );
+}
+
+TEST_CASE("Observers get batched component events", "[events]" ) {
+    World w;
+    auto a = w.requireComponent<TestComponentA>();
+
+    std::vector<std::pair<char, size_t>> log; // the kind and size of each span delivered
+    std::set<Entity> broadphase;
+    w.onAdd<TestComponentA>([&](auto es) { log.emplace_back('a', es.size()); broadphase.insert(es.begin(), es.end()); });
+    w.onSet<TestComponentA>([&](auto es) { log.emplace_back('s', es.size()); });
+    w.onRemove<TestComponentA>([&](auto es) { log.emplace_back('r', es.size()); for (auto e : es) broadphase.erase(e); });
+
+    auto es = w.newEntities(10);
+    a->setRange(es);
+    REQUIRE( log.empty() ); // nothing until a boundary
+    w.notify();
+    REQUIRE( log == std::vector<std::pair<char, size_t>>{ { 'a', 10 } } ); // a first set is only an add
+    REQUIRE( broadphase.size() == 10 );
+
+    log.clear();
+    a->setRange(std::span(es).first(5), { 1 });
+    a->mut(es[6]).a_number = 2; // not an event
+    w.kill(std::vector<Entity>(es.begin() + 7, es.end()));
+    a->del(es[0]);
+    w.notify();
+    REQUIRE( log == std::vector<std::pair<char, size_t>>{ { 's', 5 }, { 'r', 4 } } );
+    REQUIRE( broadphase.size() == 6 );
+
+    // flushed between systems, changes from inside an observer wait for the next boundary
+    log.clear();
+    w.makeSystem("spawn", [&](World* w) { w->requireComponent<TestComponentA>()->set(w->newEntity(), { 3 }); });
+    w.makeSystem("check", [&](World* w) { REQUIRE( log.size() == 1 ); });
+    w.update();
+    REQUIRE( broadphase.size() == 7 );
+}
+
+TEST_CASE("Systems run in phases and meet their ordering constraints", "[systems]" ) {
+    World w;
+
+    std::string ran;
+    w.makeSystem("render", [&](World*) { ran += "r"; })->inPhase(Phase::PostUpdate);
+    w.makeSystem("move", [&](World*) { ran += "m"; })->after("input");
+    w.makeSystem("input", [&](World*) { ran += "i"; });
+    w.makeSystem("clear", [&](World*) { ran += "c"; })->inPhase(Phase::PreUpdate);
+    w.makeSystem("collide", [&](World*) { ran += "x"; })->after("move").before("render");
+
+    w.update();
+    REQUIRE( ran == "cimxr" );
+
+    // disabled systems still order the ones around them
+    w.findSystem("move")->enable = false;
+    ran.clear();
+    w.update();
+    REQUIRE( ran == "cixr" );
+    REQUIRE( w.systemBatches().size() == 4 );
+
+    REQUIRE( w.removeSystem("clear") );
+    REQUIRE( !w.findSystem("clear") );
+    ran.clear();
+    w.update();
+    REQUIRE( ran == "ixr" );
+
+    w.findSystem("input")->after("collide");
+    REQUIRE_THROWS_AS( w.update(), std::invalid_argument );
+    w.removeSystem("input");
+    w.findSystem("render")->before("collide");
+    REQUIRE_THROWS_AS( w.update(), std::invalid_argument );
+}
+
+TEST_CASE("Ordered systems with disjoint access still batch apart", "[systems]" ) {
+    World w;
+    w.useThreads(4);
+    w.requireComponent<TestComponentA>();
+    w.requireComponent<size_t>();
+
+    w.makeSystem<TestComponentA>("a", [](Entity e, auto& ta) { });
+    w.makeSystem<size_t>("n", [](Entity e, auto& tn) { })->after("a");
+    w.makeSystem<TestComponentF>("f", [](Entity e, auto& tf) { });
+
+    auto& batches = w.systemBatches();
+    REQUIRE( batches.size() == 2 );
+    REQUIRE( batches[0].size() == 2 );
+    REQUIRE( batches[1][0]->name == "n" );
+}
+
+TEST_CASE("Systems run at their own rates", "[systems]" ) {
+    World w;
+
+    size_t frames = 0, physics = 0, ai = 0, economy = 0;
+    Seconds frameTime = 0, physicsTime = 0, aiTime = 0;
+    w.makeSystem("frame", [&](World* w) { ++frames; frameTime += w->deltaTime(); });
+    w.makeSystem("physics", [&](World* w) { ++physics; physicsTime += w->deltaTime(); })->fixedStep(Seconds(1) / 60);
+    w.makeSystem("ai", [&](World* w) { ++ai; aiTime += w->deltaTime(); })->rate(5);
+    w.makeSystem("economy", [&](World* w) { ++economy; })->rate(5);
+
+    std::vector<size_t> aiFrames, economyFrames;
+    for (size_t f = 0; f < 60; ++f) {
+        auto before = std::pair(ai, economy);
+        w.update(Seconds(1) / 30);
+        if (ai != before.first) aiFrames.push_back(f);
+        if (economy != before.second) economyFrames.push_back(f);
+    }
+
+    REQUIRE( frames == 60 );
+    REQUIRE( frameTime == Approx(2.0) );
+    REQUIRE( physics == 120 ); // two fixed steps a frame
+    REQUIRE( physicsTime == Approx(2.0) );
+    REQUIRE( ai >= 9 );
+    REQUIRE( ai <= 10 );
+    REQUIRE( economy >= 9 );
+    REQUIRE( aiTime <= 2.0 );
+    // the same rate, but not on the same frames
+    std::vector<size_t> shared;
+    std::ranges::set_intersection(aiFrames, economyFrames, std::back_inserter(shared));
+    REQUIRE( shared.empty() );
+
+    // a long frame catches up a bounded number of fixed steps
+    physics = 0;
+    w.update(1.0);
+    REQUIRE( physics == w.findSystem("physics")->maxSteps );
+    REQUIRE( w.findSystem("physics")->elapsed == 0 ); // only loose systems keep the time since they last ran
+
+    // the chunks of a parallel query see the time of the system that made it, on whatever thread they run
+    World t;
+    t.useThreads(4);
+    auto a = t.requireComponent<TestComponentA>();
+    for (size_t i = 0; i < 10000; ++i)
+        a->set(t.newEntity(), { i });
+    std::atomic<size_t> visits = 0, wrong = 0;
+    auto spread = [&](Seconds expected) {
+        return [&, expected](World* w) {
+            w->query<TestComponentA const>().par([&](Entity, auto const&) {
+                ++visits;
+                if (w->deltaTime() != expected)
+                    ++wrong;
+            }, 64);
+        };
+    };
+    t.makeSystem("loose", Access<TestComponentA const>{}, spread(0.5));
+    t.makeSystem("fixed", Access<TestComponentA const>{}, spread(0.25))->fixedStep(0.25);
+    t.update(0.5);
+    REQUIRE( visits == 3 * 10000 );
+    REQUIRE( wrong == 0 );
+}
+
+// any way of writing a Name that would skip NameSet::insert_or_assign
+template<typename T>
+concept NameWritable = requires(T& t, Entity e) { t[e]; } || requires(T& t, Entity e) { t.emplace(e, Name{}); }
+    || requires(T& t, Entity e) { { *t.find(e) } -> std::same_as<Name&>; } || requires(T& t) { { *t.begin() } -> std::same_as<Name&>; };
+
+TEST_CASE("Entity names are interned and forgotten on kill", "[names]" ) {
+    World w;
+    auto foo = w.requireEntity("foo");
+    REQUIRE( w.requireEntity("foo") == foo );
+    REQUIRE( w.findEntity("foo") == foo );
+    REQUIRE( w.findEntity("bar") == NoEntity );
+
+    // the Name views the interned text, not the caller's string
+    {
+        std::string temp = "bar";
+        auto bar = w.requireEntity(temp);
+        temp = "xxx";
+        REQUIRE( w.requireComponent<Name>()->get(bar).name == "bar" );
+        REQUIRE( w.findEntity("bar") == bar );
+    }
+
+    w.kill(foo);
+    REQUIRE( w.findEntity("foo") == NoEntity );
+    REQUIRE( w.namedEntities() == 1 );
+
+    // a reused name is a fresh entity, churn never grows the index
+    auto again = w.requireEntity("foo");
+    REQUIRE( again != foo );
+    std::vector<Entity> npcs;
+    for (int round = 0; round < 8; ++round) {
+        for (int i = 0; i < 100; ++i)
+            npcs.push_back(w.requireEntity("npc" + std::to_string(round * 100 + i)));
+        w.kill(npcs);
+        npcs.clear();
+    }
+    REQUIRE( w.namedEntities() == 2 );
+    REQUIRE( w.findEntity("npc799") == NoEntity );
+    REQUIRE( w.findEntity("foo") == again );
+
+    // removing the Name alone forgets it too
+    w.requireComponent<Name>()->del(again);
+    REQUIRE( w.findEntity("foo") == NoEntity );
+
+    // a Name set any other way is interned and indexed all the same, and renaming forgets the old name
+    auto names = w.requireComponent<Name>();
+    auto baz = w.newEntity();
+    {
+        std::string temp = "baz";
+        names->set(baz, { temp });
+        temp = "xxx";
+    }
+    REQUIRE( names->get(baz).name == "baz" );
+    REQUIRE( w.findEntity("baz") == baz );
+    names->set(baz, { names->get(baz).name.substr(1) });
+    REQUIRE( names->get(baz).name == "az" );
+    REQUIRE( w.findEntity("baz") == NoEntity );
+    REQUIRE( w.findEntity("az") == baz );
+    {
+        std::string temp = "qux";
+        w.commands().set<Name>(baz, { temp });
+        w.flush();
+    }
+    REQUIRE( w.findEntity("qux") == baz );
+    REQUIRE( w.findEntity("az") == NoEntity );
+
+    // a name given twice finds either holder, and whichever goes first leaves the other findable
+    auto twin = w.newEntity();
+    names->set(twin, { "qux" });
+    REQUIRE( (w.findEntity("qux") == baz || w.findEntity("qux") == twin) );
+    w.kill(twin);
+    REQUIRE( w.findEntity("qux") == baz );
+    REQUIRE( w.namedEntities() == 2 );
+    auto bob = w.newEntity();
+    auto bob2 = w.newEntity();
+    names->set(bob, { "bob" });
+    names->set(bob2, { "bob" });
+    w.kill(bob);
+    REQUIRE( w.findEntity("bob") == bob2 );
+    REQUIRE( names->get(bob2).name == "bob" );
+    w.kill(bob2);
+    REQUIRE( w.findEntity("bob") == NoEntity );
+    REQUIRE( w.namedEntities() == 2 );
+
+    // nothing hands out a mutable Name, so every write goes through the interner
+    STATIC_REQUIRE( std::is_same_v<decltype(names->mut(baz)), Name const&> );
+    STATIC_REQUIRE( std::is_same_v<QueryRef<Name>, Name const&> );
+    STATIC_REQUIRE( NameWritable<SparseSet<Entity, Name>> );
+    STATIC_REQUIRE( !NameWritable<NameSet> );
+    w.makeSystem<Name>("rename", [](Entity, auto& n) { STATIC_REQUIRE( std::is_const_v<std::remove_reference_t<decltype(n)>> ); });
+    w.update();
+    REQUIRE( w.findEntity("qux") == baz );
+}
+
+TEST_CASE("Profiled systems leave timing samples", "[profiling]" ) {
+    World w;
+    auto a = w.requireComponent<TestComponentA>();
+    for (size_t i = 0; i < 10; ++i)
+        a->set(w.newEntity(), { i });
+
+    w.makeSystem<TestComponentA>("count", [](Entity e, auto& ta) { ta.a_number += 1; });
+    w.makeSystem("spawn \"two\"", [](World* w) {
+        w->commands().spawn();
+        w->commands().spawn();
+    });
+
+    w.update();
+    REQUIRE( w.profiler() == nullptr );
+
+    auto p = w.profile(4);
+    REQUIRE( p == w.profiler() );
+    w.update();
+
+    std::vector<SystemSample> seen;
+    p->samples.each([&](SystemSample const& s) { seen.push_back(s); });
+    REQUIRE( seen.size() == 2 );
+    REQUIRE( p->names()[seen[0].system] == "count" );
+    REQUIRE( seen[0].visited == 10 );
+    REQUIRE( seen[0].commands == 0 );
+    REQUIRE( p->names()[seen[1].system] == "spawn \"two\"" );
+    REQUIRE( seen[1].commands == 2 );
+    REQUIRE( seen[1].start >= seen[0].start + seen[0].duration );
+
+    // the ring keeps the latest
+    w.update();
+    w.update();
+    REQUIRE( p->samples.size() == 4 );
+    REQUIRE( p->samples.dropped() == 2 );
+
+    std::ostringstream trace;
+    p->writeTrace(trace);
+    REQUIRE( trace.str().starts_with("{\"traceEvents\":[") );
+    REQUIRE( trace.str().find("\"name\":\"spawn \\\"two\\\"\"") != std::string::npos );
+    REQUIRE( trace.str().find("\"entities\":10") != std::string::npos ); // the spawned entities have no component
+
+    std::ostringstream binary;
+    p->writeBinary(binary);
+    REQUIRE( binary.str().starts_with("dsecsprf") );
+    REQUIRE( binary.str().size() == 8 + 4 + (4 + 5) + (4 + 11) + 8 + 4 * sizeof(SystemSample) );
+
+    // pool threads share the ring
+    w.useThreads(4);
+    p->samples.clear();
+    w.update();
+    REQUIRE( p->samples.size() == 2 );
+
+    w.stopProfiling();
+    w.update();
+    REQUIRE( w.profiler() == nullptr );
+}